@@ -0,0 +1,449 @@
+// headless physics benchmark, no window and no GL. runs the canonical scenes through physicsStep (systems.hpp)
+// at growing body counts and writes JSON, so physics changes have numbers next to them.
+//
+//     make bench
+//     ./bin/physics_bench --out physics.json
+//     ./bin/physics_bench --scenario pile --counts 100,1000 --steps 600 --budget 5
+//
+// scenes:
+//   rain        - cubes dropped from above onto the ground
+//   pile        - cubes already resting in layers, measures the cost of a scene that should be doing nothing
+//   tower       - columns of cubes stacked on top of each other
+//   projectiles - fast cubes flying around inside 4 walls, anything that ends up outside tunnelled through
+//   debris      - pooled cubes (prefab.hpp) tossed in from above, every step the oldest 1/60th get despawned
+//                 and respawned, so everything lives a second. spawning counts as part of the step. energy
+//                 isn't checked since respawning adds it back
+//   ramps       - rain over tilted, turned slabs inside walls. their AABBs are a lot bigger than they are,
+//                 so this is the one that exercises the SAT narrowphase (collision.hpp) and counts the AABB
+//                 overlaps it threw out
+//   spinners    - long flat slabs dropped level but spinning around the vertical axis, inside walls. they start
+//                 out unturned, so their OrientedBox and Bounds only follow because physics turns them every
+//                 step. the AABB swells and shrinks as they go round and the SAT sorts out what really touches
+//
+// every run stops when it runs out of steps or its wall clock budget (checked between bodies, so a
+// single huge step can't hang it), whichever comes first.
+// a run counts as collapsed if a body goes NaN, falls through the ground or tunnels out of the walls,
+// or if the scene gained a lot of energy (damping only takes energy away, but pushing overlapping
+// boxes apart adds a little potential energy back, so small gains are normal)
+//
+// build with make bench RELEASE=1 for numbers worth comparing, the default build is -O0
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "element.hpp"
+#include "util.hpp"
+#include "memory_tracking.hpp"
+#include "systems.hpp"
+#include "prefab.hpp"
+
+#define GRAVITY 9.8f // has to match physicsStep
+#define COLLAPSE_ENERGY_GAIN 0.05 // more than 5% more energy than we started with means the sim blew up
+
+struct Scene {
+    std::vector<Element*> Objects;
+    std::vector<Element*> bodies; // the ones that actually move
+    float extent = 10.0f; // half size of the play area
+    bool walls = false;
+    // debris only
+    Prefab* pool = nullptr;
+    std::vector<Entity> live; // in spawn order, a ring starting at oldest
+    size_t oldest = 0;
+    std::vector<SpawnTransform> spawnBuffer;
+    std::vector<Entity> spawnedBuffer;
+};
+
+struct RunResult {
+    std::string scenario;
+    int bodies = 0;
+    int steps = 0;
+    bool budgetHit = false;
+    bool skipped = false;
+    double seconds = 0.0;
+    std::vector<double> stepTimes; // ms
+    double pairTestsPerStep = 0.0;
+    double boxTestsPerStep = 0.0, boxRejectsPerStep = 0.0;
+    size_t rssBefore = 0, rssAfter = 0;
+    int64_t heapBytes = 0; // what the scene itself allocated, from the memory tracker (0 in release builds)
+    double energyStart = 0.0, energyEnd = 0.0;
+    int nanBodies = 0, fellThrough = 0, tunnelled = 0;
+    bool collapsed = false;
+    double spawnMs = 0.0; // total spent spawning and despawning (debris)
+};
+
+static Element* addAnchoredBox(Scene& scene, glm::vec3 position, glm::vec3 min, glm::vec3 max) {
+    // physics only looks at position and the bounding box, so nothing here ever gets init()'d
+    Element* e = new Element();
+    e->position = position;
+    e->bounding_box_corner1 = min;
+    e->bounding_box_corner2 = max;
+    e->anchored = true;
+    addToWorld(e, scene.Objects);
+    return e;
+}
+
+// a slab tilted by euler (radians). it gets a box to turn like a mesh would (localBounds), so it ends up with
+// an OrientedBox and the AABB around it
+static Element* addRamp(Scene& scene, glm::vec3 position, glm::vec3 halfSize, glm::vec3 euler) {
+    Element* e = new Element();
+    e->position = position;
+    e->localBoundsMin = -halfSize;
+    e->localBoundsMax = halfSize;
+    e->setRotation(euler);
+    e->fitBounds();
+    e->anchored = true;
+    addToWorld(e, scene.Objects);
+    return e;
+}
+
+static Element* addBody(Scene& scene, glm::vec3 position, glm::vec3 velocity = glm::vec3(0.0f)) {
+    Element* e = new Element(); // unit cube, the default bounding box
+    e->position = position;
+    e->velocity = velocity;
+    addToWorld(e, scene.Objects);
+    scene.bodies.push_back(e);
+    return e;
+}
+
+// the ground's top is at y = 0
+static void addGround(Scene& scene) {
+    addAnchoredBox(scene, glm::vec3(0.0f), glm::vec3(-scene.extent - 5.0f, -20.0f, -scene.extent - 5.0f), glm::vec3(scene.extent + 5.0f, 0.0f, scene.extent + 5.0f));
+}
+
+// 1 unit thick walls around the play area, anything that ends up outside them tunnelled through
+static void addWalls(Scene& scene) {
+    scene.walls = true;
+    float e = scene.extent;
+    addAnchoredBox(scene, glm::vec3(e + 0.5f, 0.0f, 0.0f), glm::vec3(-0.5f, 0.0f, -e - 1.0f), glm::vec3(0.5f, 10.0f, e + 1.0f));
+    addAnchoredBox(scene, glm::vec3(-e - 0.5f, 0.0f, 0.0f), glm::vec3(-0.5f, 0.0f, -e - 1.0f), glm::vec3(0.5f, 10.0f, e + 1.0f));
+    addAnchoredBox(scene, glm::vec3(0.0f, 0.0f, e + 0.5f), glm::vec3(-e - 1.0f, 0.0f, -0.5f), glm::vec3(e + 1.0f, 10.0f, 0.5f));
+    addAnchoredBox(scene, glm::vec3(0.0f, 0.0f, -e - 0.5f), glm::vec3(-e - 1.0f, 0.0f, -0.5f), glm::vec3(e + 1.0f, 10.0f, 0.5f));
+}
+
+// a body with a box to turn (localBounds) that physics spins, unturned to start with
+static Element* addSpinner(Scene& scene, glm::vec3 position, glm::vec3 halfSize, glm::vec3 angularVelocity) {
+    Element* e = new Element();
+    e->position = position;
+    e->localBoundsMin = e->bounding_box_corner1 = -halfSize;
+    e->localBoundsMax = e->bounding_box_corner2 = halfSize;
+    e->angularVelocity = angularVelocity;
+    addToWorld(e, scene.Objects);
+    scene.bodies.push_back(e);
+    return e;
+}
+
+static void buildRain(Scene& scene, int count, std::mt19937& rng) {
+    scene.extent = std::max(5.0f, sqrtf((float)count) * 1.5f);
+    std::uniform_real_distribution<float> spread(-scene.extent, scene.extent);
+    std::uniform_real_distribution<float> height(5.0f, 25.0f);
+    addGround(scene);
+    for (int i = 0; i < count; i++)
+        addBody(scene, glm::vec3(spread(rng), height(rng), spread(rng)));
+}
+
+static void buildPile(Scene& scene, int count, std::mt19937& rng) {
+    const int layers = 5;
+    int side = std::max(1, (int)ceilf(sqrtf((float)count / layers)));
+    scene.extent = side * 0.55f + 1.0f;
+    addGround(scene);
+    // a hair of space between neighbours so they only touch the ones under/over them
+    for (int i = 0; i < count; i++) {
+        int layer = i / (side * side), cell = i % (side * side);
+        float x = (cell % side - side * 0.5f) * 1.01f, z = (cell / side - side * 0.5f) * 1.01f;
+        addBody(scene, glm::vec3(x, 0.5f + layer, z));
+    }
+}
+
+static void buildTower(Scene& scene, int count, std::mt19937& rng) {
+    const int height = 20;
+    int columns = std::max(1, (count + height - 1) / height);
+    int side = std::max(1, (int)ceilf(sqrtf((float)columns)));
+    scene.extent = side * 1.5f + 1.0f;
+    addGround(scene);
+    for (int i = 0; i < count; i++) {
+        int column = i / height, level = i % height;
+        float x = (column % side - side * 0.5f) * 3.0f, z = (column / side - side * 0.5f) * 3.0f;
+        addBody(scene, glm::vec3(x, 0.5f + level, z));
+    }
+}
+
+static void buildProjectiles(Scene& scene, int count, std::mt19937& rng) {
+    scene.extent = std::max(10.0f, sqrtf((float)count) * 2.0f);
+    addGround(scene);
+    // thinner than a projectile travels in a step, so this is where tunnelling shows up
+    addWalls(scene);
+    float e = scene.extent;
+    std::uniform_real_distribution<float> spread(-e + 1.0f, e - 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> speed(40.0f, 120.0f);
+    std::uniform_real_distribution<float> height(1.0f, 6.0f);
+    for (int i = 0; i < count; i++) {
+        float a = angle(rng), s = speed(rng);
+        addBody(scene, glm::vec3(spread(rng), height(rng), spread(rng)), glm::vec3(cosf(a) * s, 2.0f, sinf(a) * s));
+    }
+}
+
+static void buildRamps(Scene& scene, int count, std::mt19937& rng) {
+    // ramps and rain over the middle, things come off a ramp going sideways and there's no friction, so walls
+    float area = std::max(6.0f, sqrtf((float)count) * 1.5f);
+    scene.extent = area + 3.0f;
+    addGround(scene);
+    addWalls(scene);
+    // every other one leans the other way, and they're all turned so none of them line up with the axes
+    int ramps = 0;
+    for (float x = -area + 3.0f; x < area; x += 6.0f) {
+        for (float z = -area + 3.0f; z < area; z += 6.0f) {
+            float lean = (ramps++ & 1) ? 0.5f : -0.5f;
+            addRamp(scene, glm::vec3(x, 3.0f, z), glm::vec3(2.5f, 0.25f, 1.5f), glm::vec3(0.0f, 0.6f, lean));
+        }
+    }
+    std::uniform_real_distribution<float> spread(-area, area);
+    std::uniform_real_distribution<float> height(6.0f, 25.0f);
+    for (int i = 0; i < count; i++)
+        addBody(scene, glm::vec3(spread(rng), height(rng), spread(rng)));
+}
+
+static void buildSpinners(Scene& scene, int count, std::mt19937& rng) {
+    // no friction, slabs knocked sideways would slide off the ground
+    scene.extent = std::max(6.0f, sqrtf((float)count) * 2.0f);
+    addGround(scene);
+    addWalls(scene);
+    std::uniform_real_distribution<float> spread(-scene.extent + 2.0f, scene.extent - 2.0f);
+    std::uniform_real_distribution<float> height(1.0f, 20.0f);
+    std::uniform_real_distribution<float> turnRate(-4.0f, 4.0f);
+    // only around y, so they stay level. anything else would keep tipping a corner into the ground, and
+    // with no angular response in the solver that just pumps them upward
+    for (int i = 0; i < count; i++)
+        addSpinner(scene, glm::vec3(spread(rng), height(rng), spread(rng)), glm::vec3(1.5f, 0.2f, 0.4f), glm::vec3(0.0f, turnRate(rng), 0.0f));
+}
+
+static SpawnTransform debrisTransform(const Scene& scene, std::mt19937& rng) {
+    std::uniform_real_distribution<float> spread(-scene.extent, scene.extent);
+    std::uniform_real_distribution<float> height(5.0f, 25.0f);
+    std::uniform_real_distribution<float> sideways(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> up(0.0f, 4.0f);
+    SpawnTransform transform;
+    transform.position = glm::vec3(spread(rng), height(rng), spread(rng));
+    transform.velocity = glm::vec3(sideways(rng), up(rng), sideways(rng));
+    return transform;
+}
+
+static void buildDebris(Scene& scene, int count, std::mt19937& rng) {
+    scene.extent = std::max(5.0f, sqrtf((float)count) * 1.5f);
+    addGround(scene);
+    scene.pool = new Prefab(); // unit cube, no mesh
+    scene.pool->init(count, scene.Objects);
+    for (Element& e : scene.pool->instances)
+        scene.bodies.push_back(&e);
+    scene.spawnBuffer.resize(count);
+    scene.spawnedBuffer.resize(count);
+    for (int i = 0; i < count; i++)
+        scene.spawnBuffer[i] = debrisTransform(scene, rng);
+    scene.live.resize(count);
+    spawn(*scene.pool, count, scene.spawnBuffer.data(), scene.Objects, scene.live.data());
+}
+
+// despawns the oldest and spawns as many new ones in their place
+static void churnDebris(Scene& scene, std::mt19937& rng) {
+    size_t count = std::max<size_t>(1, scene.live.size() / 60);
+    for (size_t i = 0; i < count; i++) {
+        despawn(*scene.pool, scene.live[(scene.oldest + i) % scene.live.size()]);
+        scene.spawnBuffer[i] = debrisTransform(scene, rng);
+    }
+    spawn(*scene.pool, count, scene.spawnBuffer.data(), scene.Objects, scene.spawnedBuffer.data());
+    for (size_t i = 0; i < count; i++)
+        scene.live[(scene.oldest + i) % scene.live.size()] = scene.spawnedBuffer[i];
+    scene.oldest = (scene.oldest + count) % scene.live.size();
+}
+
+// kinetic + potential, unit mass
+static double totalEnergy(const Scene& scene) {
+    double energy = 0.0;
+    for (const Element* e : scene.bodies) {
+        if (!e->objects) continue; // a despawned pool instance
+        if (!std::isfinite(e->position.y)) continue;
+        energy += 0.5 * glm::dot(e->velocity, e->velocity) + GRAVITY * e->position.y;
+    }
+    return energy;
+}
+
+static RunResult run(const std::string& scenario, int count, int maxSteps, double budget) {
+    RunResult result;
+    result.scenario = scenario;
+    result.bodies = count;
+    result.rssBefore = currentRSS();
+
+    Scene scene;
+    std::mt19937 rng(1234);
+    int64_t heapBefore = memoryStats(MemoryTag::Physics).heapBytes;
+    {
+        MEMORY_TAG(MemoryTag::Physics);
+        if (scenario == "rain") buildRain(scene, count, rng);
+        else if (scenario == "pile") buildPile(scene, count, rng);
+        else if (scenario == "tower") buildTower(scene, count, rng);
+        else if (scenario == "debris") buildDebris(scene, count, rng);
+        else if (scenario == "ramps") buildRamps(scene, count, rng);
+        else if (scenario == "spinners") buildSpinners(scene, count, rng);
+        else buildProjectiles(scene, count, rng);
+    }
+    result.heapBytes = memoryStats(MemoryTag::Physics).heapBytes - heapBefore;
+
+    const float dt = 1.0f / 60.0f; // same fixed step as the game loop
+    result.energyStart = totalEnergy(scene);
+    unsigned long long pairTestsStart = physicsPairTests, boxTestsStart = physicsBoxTests, boxRejectsStart = physicsBoxRejects;
+    auto runStart = std::chrono::steady_clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count(); };
+
+    pushElements(world);
+    for (int step = 0; step < maxSteps && !result.budgetHit; step++) {
+        auto stepStart = std::chrono::steady_clock::now();
+        if (scene.pool) {
+            churnDebris(scene, rng);
+            result.spawnMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count();
+        }
+        if (!physicsStep(world, dt, [&]() { return elapsed() > budget; })) {
+            result.budgetHit = true; // this step is unfinished, don't count it
+            break;
+        }
+        result.stepTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepStart).count());
+        result.steps++;
+        if (elapsed() > budget) result.budgetHit = true;
+    }
+    result.seconds = elapsed();
+    pullElements(world);
+    result.rssAfter = currentRSS();
+    result.pairTestsPerStep = result.steps > 0 ? (double)(physicsPairTests - pairTestsStart) / result.steps : 0.0;
+    result.boxTestsPerStep = result.steps > 0 ? (double)(physicsBoxTests - boxTestsStart) / result.steps : 0.0;
+    result.boxRejectsPerStep = result.steps > 0 ? (double)(physicsBoxRejects - boxRejectsStart) / result.steps : 0.0;
+    result.energyEnd = totalEnergy(scene);
+
+    for (const Element* e : scene.bodies) {
+        if (!e->objects) continue;
+        glm::vec3 p = e->position;
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) result.nanBodies++;
+        else if (p.y < -0.5f) result.fellThrough++; // center is below the ground's surface
+        else if (scene.walls && (fabsf(p.x) > scene.extent || fabsf(p.z) > scene.extent)) result.tunnelled++;
+    }
+    bool gainedEnergy = !scene.pool && result.energyEnd > result.energyStart + COLLAPSE_ENERGY_GAIN * fabs(result.energyStart) + 1e-3;
+    // a half done step leaves the scene in a state nobody would see, so only judge runs that got somewhere
+    result.collapsed = result.steps > 0 && (result.nanBodies > 0 || result.fellThrough > 0 || result.tunnelled > 0 || gainedEnergy);
+
+    delete scene.pool; // first, its instances are in Objects but weren't new'd
+    while (!scene.Objects.empty()) delete scene.Objects.back(); // deleting takes it out of Objects
+    world.clear(); // the pool's reserves outlive it, the next run starts from nothing
+    return result;
+}
+
+static void percentiles(std::vector<double> samples, double& p50, double& p99) {
+    p50 = p99 = 0.0;
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    p50 = samples[std::min((size_t)(0.50 * samples.size()), samples.size() - 1)];
+    p99 = samples[std::min((size_t)(0.99 * samples.size()), samples.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> scenarios = {"rain", "pile", "tower", "projectiles", "debris", "ramps", "spinners"};
+    std::vector<int> counts = {100, 1000, 10000, 100000};
+    int steps = 600; // 10 simulated seconds
+    double budget = 10.0; // wall clock seconds per run
+    const char* outPath = "physics.json";
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() { return i + 1 < argc ? argv[++i] : (char*)""; };
+        if (strcmp(argv[i], "--scenario") == 0) scenarios = {next()};
+        else if (strcmp(argv[i], "--counts") == 0) {
+            counts.clear();
+            for (char* token = strtok(next(), ","); token; token = strtok(nullptr, ","))
+                counts.push_back(atoi(token));
+        }
+        else if (strcmp(argv[i], "--steps") == 0) steps = atoi(next());
+        else if (strcmp(argv[i], "--budget") == 0) budget = atof(next());
+        else if (strcmp(argv[i], "--out") == 0) outPath = next();
+        else {
+            printf("usage: %s [--scenario rain|pile|tower|projectiles|debris|ramps|spinners] [--counts 100,1000,...] [--steps N] [--budget seconds] [--out file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (const std::string& scenario : scenarios) {
+        if (scenario != "rain" && scenario != "pile" && scenario != "tower" && scenario != "projectiles" && scenario != "debris" && scenario != "ramps" && scenario != "spinners") {
+            printf("physics_bench.cpp: unknown scenario %s\n", scenario.c_str());
+            return 1;
+        }
+    }
+
+    FILE* file = fopen(outPath, "w");
+    if (!file) {
+        printf("physics_bench.cpp: couldn't open %s\n", outPath);
+        return 1;
+    }
+    fprintf(file, "{\n  \"dt\": %.6f,\n  \"max_steps\": %i,\n  \"budget_seconds\": %.1f,\n  \"runs\": [\n", 1.0f / 60.0f, steps, budget);
+
+    printf("%-12s %8s %7s %10s %10s %10s %14s %10s %9s  %s\n", "scenario", "bodies", "steps", "steps/s", "p50 ms", "p99 ms", "pairs/step", "RSS MB", "drift", "");
+    bool firstRun = true;
+    for (const std::string& scenario : scenarios) {
+        bool overBudget = false;
+        for (int count : counts) {
+            RunResult r;
+            if (overBudget) {
+                // the last size didn't finish a single step in time, a bigger one won't either
+                r.scenario = scenario;
+                r.bodies = count;
+                r.budgetHit = true;
+                r.skipped = true;
+            } else {
+                r = run(scenario, count, steps, budget);
+            }
+            if (r.steps == 0) overBudget = true;
+
+            double p50, p99;
+            percentiles(r.stepTimes, p50, p99);
+            double stepsPerSecond = 0.0;
+            for (double t : r.stepTimes) stepsPerSecond += t;
+            stepsPerSecond = stepsPerSecond > 0.0 ? r.steps / (stepsPerSecond / 1000.0) : 0.0;
+            double drift = r.energyStart != 0.0 ? (r.energyEnd - r.energyStart) / fabs(r.energyStart) : 0.0;
+            std::string notes;
+            if (r.skipped) notes += "skipped, a smaller run already couldn't finish a step";
+            else if (r.budgetHit) notes += r.steps == 0 ? "no step finished in budget " : "budget hit ";
+            if (r.collapsed) notes += "COLLAPSED";
+            if (r.steps > 0 && r.nanBodies) notes += " nan:" + std::to_string(r.nanBodies);
+            if (r.steps > 0 && r.fellThrough) notes += " fell through:" + std::to_string(r.fellThrough);
+            if (r.steps > 0 && r.tunnelled) notes += " tunnelled:" + std::to_string(r.tunnelled);
+            if (r.boxTestsPerStep > 0.0) {
+                char sat[64];
+                snprintf(sat, sizeof(sat), " sat/step:%.0f rejected:%.0f", r.boxTestsPerStep, r.boxRejectsPerStep);
+                notes += sat;
+            }
+
+            printf("%-12s %8i %7i %10.1f %10.3f %10.3f %14.0f %10.1f %8.1f%%  %s\n", scenario.c_str(), count, r.steps, stepsPerSecond, p50, p99,
+                r.pairTestsPerStep, r.rssAfter / (1024.0 * 1024.0), drift * 100.0, notes.c_str());
+            fflush(stdout);
+
+            fprintf(file, "%s    {\n", firstRun ? "" : ",\n");
+            fprintf(file, "      \"scenario\": \"%s\",\n      \"bodies\": %i,\n      \"steps\": %i,\n      \"budget_hit\": %s,\n      \"skipped\": %s,\n", scenario.c_str(), count, r.steps, r.budgetHit ? "true" : "false", r.skipped ? "true" : "false");
+            fprintf(file, "      \"seconds\": %.4f,\n      \"steps_per_second\": %.3f,\n      \"step_ms_p50\": %.4f,\n      \"step_ms_p99\": %.4f,\n", r.seconds, stepsPerSecond, p50, p99);
+            fprintf(file, "      \"pair_tests_per_step\": %.1f,\n", r.pairTestsPerStep);
+            fprintf(file, "      \"sat_tests_per_step\": %.1f,\n      \"sat_rejects_per_step\": %.1f,\n", r.boxTestsPerStep, r.boxRejectsPerStep);
+            if (scenario == "debris")
+                fprintf(file, "      \"spawn_ms_per_step\": %.4f,\n", r.steps > 0 ? r.spawnMs / r.steps : 0.0);
+            fprintf(file, "      \"heap_bytes\": %lld,\n      \"heap_bytes_per_body\": %.1f,\n", (long long)r.heapBytes, count > 0 ? (double)r.heapBytes / count : 0.0);
+            fprintf(file, "      \"rss_bytes\": %zu,\n      \"rss_growth_bytes\": %lld,\n", r.rssAfter, (long long)r.rssAfter - (long long)r.rssBefore);
+            fprintf(file, "      \"energy_start\": %.4f,\n      \"energy_end\": %.4f,\n      \"energy_drift\": %.6f,\n", r.energyStart, r.energyEnd, drift);
+            fprintf(file, "      \"nan_bodies\": %i,\n      \"fell_through\": %i,\n      \"tunnelled\": %i,\n      \"collapsed\": %s\n", r.nanBodies, r.fellThrough, r.tunnelled, r.collapsed ? "true" : "false");
+            fprintf(file, "    }");
+            firstRun = false;
+        }
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    printf("physics_bench.cpp: wrote %s\n", outPath);
+    return 0;
+}
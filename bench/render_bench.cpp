@@ -0,0 +1,354 @@
+// offscreen render benchmark, no window or display needed (EGL surfaceless, works on mesa llvmpipe)
+// builds procedural scenes out of the premade cubes/quads, flies a scripted camera around them
+// and writes timings as JSON so runs from different commits can be diffed.
+//
+//     make bench
+//     ./bin/render_bench --out bench.json
+//     ./bin/render_bench --cubes 2000 --quads 100 --lights 300 --frames 300 --deferred
+//     ./bin/render_bench --cubes 10000 --debug-draw   (every bounding box drawn through debug_draw.hpp)
+//
+// without --cubes/--quads/--lights it runs the whole suite (every scene in every render mode)
+// frames after warm-up aren't supposed to allocate, if one does it prints a warning and exits with 1
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "element.hpp"
+#include "util.hpp"
+#include "premade_elements.hpp"
+#include "shader_def.hpp"
+#include "renderer.hpp"
+#include "render_snapshot.hpp"
+#include "debug_draw.hpp"
+#include "memory_tracking.hpp"
+
+struct BenchScene {
+    std::string name;
+    int cubes, quads, lights;
+};
+
+struct BenchMode {
+    const char* name;
+    bool deferred, prepass;
+};
+
+struct Percentiles {
+    double mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+};
+
+static Percentiles percentiles(std::vector<double> samples) {
+    Percentiles result;
+    if (samples.empty()) return result;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double p) { return samples[std::min((size_t)(p * samples.size()), samples.size() - 1)]; };
+    for (double s : samples) result.mean += s;
+    result.mean /= samples.size();
+    result.p50 = at(0.50);
+    result.p95 = at(0.95);
+    result.p99 = at(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+static void writePercentiles(FILE* file, const char* name, const Percentiles& p, bool last = false) {
+    fprintf(file, "      \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+        name, p.mean, p.p50, p.p95, p.p99, p.max, last ? "" : ",");
+}
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+
+static bool createContext() {
+    // llvmpipe only advertises 4.5 by default, the shaders want 4.6. does nothing on other drivers
+    setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+    setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cout << "render_bench.cpp: couldn't get an EGL display\n";
+        return false;
+    }
+    eglBindAPI(EGL_OPENGL_API);
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 6,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    // no config and no surface, everything gets drawn into our own FBO
+    context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cout << "render_bench.cpp: couldn't create a 4.6 core context (EGL_KHR_surfaceless_context and EGL_KHR_no_config_context are needed)\n";
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cout << "render_bench.cpp: Failed to initalize GLAD\n";
+        return false;
+    }
+    return true;
+}
+
+// everything is placed with a fixed seed so every run (and every commit) gets the same scene
+static void buildScene(const BenchScene& scene, std::vector<Element*>& Objects, std::vector<Element*>& owned) {
+    MEMORY_TAG(MemoryTag::Meshes);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float extent = 8.0f + sqrtf((float)scene.cubes); // keep density roughly the same as the scene grows
+
+    Element* ground = new Element();
+    ground->vertices = {QUAD_VERTICES};
+    ground->indices = {QUAD_INDICES};
+    ground->position.y = -1.0f;
+    ground->sizex = extent + 4.0f;
+    ground->sizez = extent + 4.0f;
+    ground->useTexture = true;
+    ground->textureFile = "textures/grass.jpg";
+    ground->anchored = true;
+    ground->shader = objectShader;
+    ground->init();
+    addToWorld(ground, Objects);
+    owned.push_back(ground);
+
+    for (int i = 0; i < scene.cubes; i++) {
+        Element* cube = new Element();
+        cube->vertices = {CUBE_VERTICES};
+        cube->indices = {CUBE_INDICES};
+        cube->position = glm::vec3(spread(rng) * extent, -0.5f + unit(rng) * 3.0f, spread(rng) * extent);
+        cube->setRotation(glm::vec3(0.0f, unit(rng) * 6.28f, 0.0f));
+        cube->anchored = true;
+        cube->shader = objectShader;
+        cube->init();
+        addToWorld(cube, Objects);
+        owned.push_back(cube);
+    }
+    for (int i = 0; i < scene.quads; i++) {
+        // standing panels
+        Element* quad = new Element();
+        quad->vertices = {QUAD_VERTICES};
+        quad->indices = {QUAD_INDICES};
+        quad->position = glm::vec3(spread(rng) * extent, 1.0f, spread(rng) * extent);
+        quad->setRotation(glm::vec3(1.5708f, 0.0f, unit(rng) * 6.28f));
+        quad->sizex = 1.0f + unit(rng) * 2.0f;
+        quad->sizez = 1.0f + unit(rng) * 2.0f;
+        quad->anchored = true;
+        quad->shader = objectShader;
+        quad->init();
+        addToWorld(quad, Objects);
+        owned.push_back(quad);
+    }
+    for (int i = 0; i < scene.lights; i++) {
+        Element* light = new Element();
+        light->vertices = {CUBE_VERTICES};
+        light->indices = {CUBE_INDICES};
+        light->position = glm::vec3(spread(rng) * extent, 0.5f + unit(rng) * 2.0f, spread(rng) * extent);
+        light->sizex = light->sizey = light->sizez = 0.1f;
+        light->emitPointLight = true;
+        light->pointLightColor = glm::vec3(0.3f + unit(rng) * 0.7f, 0.3f + unit(rng) * 0.7f, 0.3f + unit(rng) * 0.7f);
+        light->pointLightLinear = 0.35f;
+        light->pointLightQuadratic = 0.44f;
+        light->anchored = true;
+        light->hasCollision = false;
+        light->shader = debugShader;
+        light->init(); // also adds it to PointLights
+        addToWorld(light, Objects);
+        owned.push_back(light);
+    }
+}
+
+// circles the scene, bobbing up and down, always looking at the middle
+static void scriptedCamera(Camera& camera, int frame, int frames, float extent) {
+    float t = (float)frame / frames;
+    float angle = t * 6.28318f;
+    float radius = extent * (0.6f + 0.3f * sinf(angle * 2.0f));
+    glm::vec3 position(cosf(angle) * radius, 3.0f + 2.0f * sinf(angle * 3.0f), sinf(angle) * radius);
+    camera.setPos(position);
+    camera.setFront(glm::normalize(glm::vec3(0.0f, 0.0f, 0.0f) - position));
+}
+
+int main(int argc, char** argv) {
+    int width = 1280, height = 720, frames = 240, warmup = 20;
+    const char* outPath = "bench.json";
+    BenchScene custom{"custom", -1, 0, 0};
+    bool onlyDeferred = false, onlyPrepass = false;
+    renderDebug = false; // the game starts with it on, keep runs comparable unless asked for
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() { return i + 1 < argc ? argv[++i] : (char*)"0"; };
+        if (strcmp(argv[i], "--cubes") == 0) custom.cubes = atoi(next());
+        else if (strcmp(argv[i], "--quads") == 0) custom.quads = atoi(next());
+        else if (strcmp(argv[i], "--lights") == 0) custom.lights = atoi(next());
+        else if (strcmp(argv[i], "--frames") == 0) frames = atoi(next());
+        else if (strcmp(argv[i], "--warmup") == 0) warmup = atoi(next());
+        else if (strcmp(argv[i], "--width") == 0) width = atoi(next());
+        else if (strcmp(argv[i], "--height") == 0) height = atoi(next());
+        else if (strcmp(argv[i], "--out") == 0) outPath = next();
+        else if (strcmp(argv[i], "--deferred") == 0) onlyDeferred = true;
+        else if (strcmp(argv[i], "--prepass") == 0) onlyPrepass = true;
+        else if (strcmp(argv[i], "--debug-draw") == 0) renderDebug = true;
+        else {
+            printf("usage: %s [--cubes N --quads N --lights N] [--deferred] [--prepass] [--debug-draw] [--frames N] [--warmup N] [--width W --height H] [--out file.json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<BenchScene> scenes;
+    std::vector<BenchMode> modes;
+    if (custom.cubes >= 0) {
+        scenes.push_back(custom);
+        modes.push_back({onlyDeferred ? (onlyPrepass ? "deferred+prepass" : "deferred") : (onlyPrepass ? "forward+prepass" : "forward"), onlyDeferred, onlyPrepass});
+    } else {
+        scenes = {
+            {"small", 100, 10, 16},
+            {"medium", 1000, 50, 128},
+            {"large", 4000, 200, 512},
+        };
+        modes = {
+            {"forward", false, false},
+            {"forward+prepass", false, true},
+            {"deferred", true, false},
+        };
+    }
+
+    if (!createContext()) return 1;
+    printf("render_bench.cpp: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    initShaders();
+    memoryCheckpoint(); // every run cleans up after itself, so the leak report at the end should come out empty
+
+    // offscreen target, same formats as a normal window
+    unsigned int FBO, colorRBO, depthRBO;
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glGenRenderbuffers(1, &colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "render_bench.cpp: offscreen framebuffer is not complete!\n";
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+    glEnable(GL_DEPTH_TEST);
+
+    FILE* file = fopen(outPath, "w");
+    if (!file) {
+        printf("render_bench.cpp: couldn't open %s\n", outPath);
+        return 1;
+    }
+    fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"width\": %i,\n  \"height\": %i,\n  \"frames\": %i,\n  \"runs\": [\n", (const char*)glGetString(GL_RENDERER), width, height, frames);
+
+    bool firstRun = true;
+    int allocatingRuns = 0; // runs where a frame after warm-up still hit the heap
+    for (const BenchScene& scene : scenes) {
+        for (const BenchMode& mode : modes) {
+            std::vector<Element*> Objects, owned;
+            PointLights.clear();
+            buildScene(scene, Objects, owned);
+            float extent = 8.0f + sqrtf((float)scene.cubes);
+
+            renderDeferred = mode.deferred;
+            renderDepthPrepass = mode.prepass;
+            Renderer* renderer = new Renderer(); // fresh one per run, so no caches carry over
+            renderer->init(width, height);
+            renderer->outputFBO = FBO;
+            renderer->sun.color = glm::vec3(0.3f);
+            Camera camera;
+            RenderSnapshot snapshot; // reused, so it stops allocating after the first frame
+
+            std::vector<double> submitTimes, frameTimes, gpuTimes;
+            submitTimes.reserve(frames);
+            frameTimes.reserve(frames);
+            gpuTimes.reserve(frames);
+            RenderStats lastStats;
+            uint64_t maxAllocations = 0, totalAllocations = 0; // heap allocations per measured frame
+            for (int frame = 0; frame < warmup + frames; frame++) {
+                scriptedCamera(camera, std::max(frame - warmup, 0), frames, extent);
+                // the game's simulation side does this, so it isn't part of the measured frame
+                captureSnapshot(snapshot, Objects, PointLights, camera);
+                uint64_t allocationsBefore = heapAllocations();
+                auto start = std::chrono::steady_clock::now();
+                renderer->render(snapshot, width, height, 1.0f / 60.0f);
+                auto submitted = std::chrono::steady_clock::now();
+                glFinish(); // no swap to pace us, so wait for the gpu to make frame time mean something
+                auto finished = std::chrono::steady_clock::now();
+                if (frame < warmup) continue;
+                uint64_t allocations = heapAllocations() - allocationsBefore;
+                maxAllocations = std::max(maxAllocations, allocations);
+                totalAllocations += allocations;
+                submitTimes.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(finished - start).count());
+                if (renderer->gpuTimers.frameMilliseconds > 0.0)
+                    gpuTimes.push_back(renderer->gpuTimers.frameMilliseconds);
+                lastStats = renderer->stats;
+            }
+
+            Percentiles frame = percentiles(frameTimes);
+            printf("render_bench.cpp: %-8s %-16s frame p50 %.3f ms p99 %.3f ms, submit p50 %.3f ms, %i draws, %llu allocs/frame max\n",
+                scene.name.c_str(), mode.name, frame.p50, frame.p99, percentiles(submitTimes).p50, lastStats.drawCalls, (unsigned long long)maxAllocations);
+            if (maxAllocations > 0) {
+                // everything the renderer needs should be sized during warm-up, anything after that is a regression
+                printf("render_bench.cpp: warning: %s %s allocated %llu times after warm-up\n", scene.name.c_str(), mode.name, (unsigned long long)totalAllocations);
+                allocatingRuns++;
+            }
+            fprintf(file, "%s    {\n", firstRun ? "" : ",\n");
+            fprintf(file, "      \"scene\": \"%s\",\n      \"mode\": \"%s\",\n", scene.name.c_str(), mode.name);
+            fprintf(file, "      \"cubes\": %i,\n      \"quads\": %i,\n      \"lights\": %i,\n", scene.cubes, scene.quads, scene.lights);
+            fprintf(file, "      \"draw_calls\": %i,\n      \"triangles\": %i,\n      \"state_changes\": %i,\n      \"overdraw\": %.3f,\n",
+                lastStats.drawCalls + lastStats.depthDrawCalls, lastStats.triangles, lastStats.stateChanges, lastStats.overdraw);
+            fprintf(file, "      \"light_cluster_pairs\": %zu,\n", renderer->lightClusters.assignedCount);
+            fprintf(file, "      \"debug_vertices\": %zu,\n", debugDraw.lastVertexCount);
+            fprintf(file, "      \"heap_allocations_per_frame\": {\"mean\": %.2f, \"max\": %llu},\n", frames > 0 ? (double)totalAllocations / frames : 0.0, (unsigned long long)maxAllocations);
+            fprintf(file, "      \"memory\": {");
+            for (int i = 0; i < (int)MemoryTag::Count; i++) {
+                MemoryTagStats memory = memoryStats((MemoryTag)i);
+                fprintf(file, "%s\"%s\": {\"heap_bytes\": %lld, \"gpu_bytes\": %lld}", i ? ", " : "", memoryTagName((MemoryTag)i), (long long)memory.heapBytes, (long long)memory.gpuBytes);
+            }
+            fprintf(file, "},\n");
+            writePercentiles(file, "cpu_submit_ms", percentiles(submitTimes));
+            writePercentiles(file, "gpu_ms", percentiles(gpuTimes));
+            writePercentiles(file, "frame_ms", frame, true);
+            fprintf(file, "    }");
+            firstRun = false;
+
+            delete renderer;
+            for (Element* e : owned) delete e;
+            PointLights.clear();
+        }
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    printf("render_bench.cpp: wrote %s\n", outPath);
+
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteRenderbuffers(1, &colorRBO);
+    glDeleteRenderbuffers(1, &depthRBO);
+    // the driver keeps caches around for as long as the context lives, take it down before looking for leaks
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    printLeakReport();
+    if (allocatingRuns > 0) {
+        printf("render_bench.cpp: %i runs allocated in steady state frames\n", allocatingRuns);
+        return 1;
+    }
+    return 0;
+}
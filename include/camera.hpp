@@ -39,20 +39,32 @@ struct Camera {
         void setYaw(float aYaw) {
             yaw = aYaw;
         }
-        glm::vec3 getOrientation() {
+        glm::vec3 getOrientation() const {
             return front;
         }
-        glm::vec3 getUp() {
+        glm::vec3 getUp() const {
             return up;
         }
-        glm::vec3 getPos() {
+        glm::vec3 getPos() const {
             return pos;
         }
-        glm::vec3 getOffset() {
+        glm::vec3 getOffset() const {
             return offset;
         }
-        float getYaw() {return yaw;}
-        float getPitch() {return pitch;}
+        // adds to yaw/pitch and points front that way right away, like Player::orient does on the next update.
+        // main uses it to late-latch mouse movement into a snapshot's camera
+        void turn(float yawDegrees, float pitchDegrees) {
+            yaw += yawDegrees;
+            pitch += pitchDegrees;
+            update();
+            glm::vec3 direction;
+            direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+            direction.y = sin(glm::radians(pitch));
+            direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+            front = glm::normalize(direction);
+        }
+        float getYaw() const {return yaw;}
+        float getPitch() const {return pitch;}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef COLLISION_HPP
+#define COLLISION_HPP
+
+#include <glm/glm.hpp>
+
+#include "components.hpp"
+
+// narrowphase for anything rotated. the world AABB (Bounds) stays what the broadphase checks, but for a
+// rotated box it can be a lot bigger than the box itself (a wall at 45 degrees gets a box twice as deep),
+// so once the AABBs overlap collideBoxes runs the separating axis test on the real oriented boxes:
+// the 3 face normals of each box and the 9 cross products of their edges. if any of those 15 axes has a
+// gap the boxes don't touch, otherwise the axis with the least overlap is the contact normal.
+// the axes get tested 4 at a time with SSE when we have it, there's a plain loop for everything else
+
+struct Contact {
+    glm::vec3 normal; // unit, from b toward a, a moves along it to get out
+    float depth; // how far a has to move
+    glm::vec3 point; // world space, roughly where they touch. for debugging, the response doesn't need it
+};
+
+// a and b are relative to their positions (OrientedBox::center)
+bool collideBoxes(glm::vec3 positionA, const OrientedBox& a, glm::vec3 positionB, const OrientedBox& b, Contact& contact);
+// an unrotated box, for testing a plain Bounds against an OrientedBox. only the world space part is filled in
+OrientedBox axisAlignedBox(const Bounds& bounds);
+// localMin/localMax (already scaled by size) turned by parentBasis * orientation, the same box the Bounds are fit around
+OrientedBox orientedBox(const glm::mat3& parentBasis, const glm::quat& orientation, glm::vec3 localMin, glm::vec3 localMax);
+// rebuilds center, axes and halfExtents from the local part for a new orientation
+void turnBox(OrientedBox& box, const glm::quat& orientation);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class Element;
+
+// the components the game's world is made of (ecs.hpp). an Element added with addToWorld gets:
+//   Transform, Bounds, ElementLink   always
+//   Motion                           unless it's anchored or attached in the scene graph
+//   Collider                         if it has collision and isn't a debug element
+//   Spin                             while its angularVelocity isn't zero, anchored or not
+//   OrientedBox                      if it has a Collider, is rotated or spinning and has a mesh box to rotate
+//   Drawable                         once it's been init()'d
+// so physics walks Transform+Bounds+Motion and never sees the ground, etc. the renderer doesn't look at the
+// world at all, it draws from a RenderSnapshot (render_snapshot.hpp) the simulation hands it
+
+struct Transform {
+    glm::vec3 position;
+    glm::vec3 previousPosition; // before the last physics step, what rendering interpolates from
+    glm::quat orientation;
+    glm::quat previousOrientation;
+};
+
+// bounding_box_corner1/2, relative to position
+struct Bounds {
+    glm::vec3 min, max;
+};
+
+struct Motion {
+    glm::vec3 velocity;
+    glm::vec3 holdVelocity;
+    glm::vec3 lastPosition;
+    float bounceAmount;
+    bool gravity;
+    bool bounce;
+    bool grounded;
+};
+
+// turning, radians per second around each world axis. physics refits Bounds around the local box after
+// every step it turns, so the broadphase doesn't wait for the frame to catch up
+struct Spin {
+    glm::vec3 angularVelocity;
+    glm::vec3 localMin, localMax; // Element::localBoundsMin/Max scaled by size, the same for both if there's no box to turn
+    glm::mat3 parentBasis; // Element::sceneBasis, turns us on top of orientation
+};
+
+// other things can hit it
+struct Collider {
+    int id; // Element::id, things with the same id don't collide
+};
+
+// the real box of a rotated Collider. Bounds is the AABB around it, which physics only uses to find
+// candidates, what actually touches gets decided on this (collision.hpp). the world space part gets
+// rebuilt from the local part every step a Spin turns it (turnBox)
+struct OrientedBox {
+    glm::vec3 center; // relative to position, like Bounds
+    glm::vec3 axes[3]; // unit length, world space
+    glm::vec3 halfExtents;
+    glm::vec3 localCenter, localHalfExtents; // the local box, scaled by size
+    glm::mat3 parentBasis; // Element::sceneBasis, turns us on top of orientation
+};
+
+struct Drawable {
+    Element* element;
+    bool opaque; // lit by objectShader, goes through the sorted opaque pass
+};
+
+// back to the Element this entity was made from, see systems.hpp
+struct ElementLink {
+    Element* element;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef DEBUG_DRAW_HPP
+#define DEBUG_DRAW_HPP
+
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// immediate mode debug lines. call line/box/sphere/... from anywhere on the main thread during the frame,
+// they get written straight into a persistently mapped buffer and the renderer draws all of them with one
+// glDrawArrays(GL_LINES) at the end of the frame (flush). nothing is kept, next frame starts empty:
+//
+//     debugDraw.box(e->position + e->bounding_box_corner1, e->position + e->bounding_box_corner2, glm::vec3(1.0f, 0.0f, 0.0f));
+//
+// the buffer is a ring of DEBUG_DRAW_FRAMES sections, one per frame in flight, each guarded by a fence so
+// we never write into a section the gpu is still reading. anything past DEBUG_DRAW_MAX_VERTICES in a frame
+// gets dropped (and counted). calls do nothing while renderDebug is off or before the renderer init()'d us.
+#define DEBUG_DRAW_MAX_VERTICES (1 << 18) // per frame, a 10k body scene's boxes is 240k
+#define DEBUG_DRAW_FRAMES 3
+
+// 16 bytes, color packed to RGBA8
+struct DebugVertex {
+    glm::vec3 position;
+    uint32_t color;
+};
+
+class DebugDraw {
+    public:
+        void init();
+        void release(); // before the GL context goes away
+
+        void line(glm::vec3 from, glm::vec3 to, glm::vec3 color);
+        // direction doesn't need to be normalized, colored by direction if no color is given like the old debug lines
+        void ray(glm::vec3 origin, glm::vec3 direction, float length);
+        void ray(glm::vec3 origin, glm::vec3 direction, float length, glm::vec3 color);
+        void arrow(glm::vec3 from, glm::vec3 to, glm::vec3 color, float headSize = 0.1f);
+        void box(glm::vec3 min, glm::vec3 max, glm::vec3 color);
+        // three circles, one around each axis
+        void sphere(glm::vec3 center, float radius, glm::vec3 color, int segments = 16);
+        // small 3 axis cross, e.g. a contact point
+        void point(glm::vec3 position, float size, glm::vec3 color);
+
+        // draws everything from this frame with the debug shader and moves on to the next section of the ring
+        // returns how many draw calls it made (0 or 1)
+        int flush(const glm::mat4& view, const glm::mat4& projection);
+
+        bool ready() const { return mapped != nullptr; }
+        size_t vertexCount = 0; // this frame so far
+        size_t lastVertexCount = 0; // what the last flush drew
+        size_t droppedVertices = 0; // total that didn't fit
+        ~DebugDraw();
+    private:
+        // room for count more vertices this frame, nullptr if we're not drawing or it doesn't fit
+        DebugVertex* reserve(size_t count);
+        void waitForSection(int which);
+
+        unsigned int VAO = 0, VBO = 0;
+        DebugVertex* mapped = nullptr; // the whole ring
+        GLsync fences[DEBUG_DRAW_FRAMES] = {};
+        int section = 0;
+};
+
+extern DebugDraw debugDraw;
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef ECS_HPP
+#define ECS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// archetype entity component system
+// every distinct set of components an entity can have is an archetype, and each archetype keeps its entities
+// in fixed size chunks where every component is its own tightly packed array (SoA). so a system that wants
+// Transform + Motion walks arrays of exactly those, and never even looks at entities that don't have them:
+//
+//     world.each<Transform, Motion>([&](Entity e, Transform& transform, Motion& motion) {
+//         transform.position += motion.velocity * dt;
+//     });
+//
+// or chunk at a time with eachChunk, which hands over the raw arrays for loops the compiler can vectorize.
+// adding/removing a component moves the entity to another archetype, destroying swaps the last entity of the
+// chunk list into the hole, so pointers into chunks only stay good until the next create/destroy/setMask.
+// don't create or destroy while iterating. components have to be trivially copyable (they get memcpy'd around).
+//
+// entities are handles into a slot map: index picks the slot, generation says which use of the slot it is.
+// destroying bumps the slot's generation and puts it on a free list, so create and destroy are both O(1),
+// slots get reused, and a handle kept around after its entity died just stops being alive() instead of
+// pointing at whatever got the slot next. hold on to Entity, not pointers into components.
+
+struct Entity {
+    uint32_t index = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+#define NO_ENTITY Entity()
+
+typedef uint32_t ComponentMask;
+#define ECS_MAX_COMPONENTS 32
+#define ECS_CHUNK_BYTES (16 * 1024)
+
+// sizes of every component type that has been given an id, indexed by id
+extern size_t componentSizes[ECS_MAX_COMPONENTS];
+int registerComponent(size_t size);
+
+// ids get handed out the first time a type is asked about
+template<typename T>
+int componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "components get memcpy'd between chunks");
+    static int id = registerComponent(sizeof(T));
+    return id;
+}
+
+template<typename... Ts>
+ComponentMask componentMask() {
+    return (ComponentMask(0) | ... | (ComponentMask(1) << componentId<Ts>()));
+}
+
+class Archetype {
+    public:
+        explicit Archetype(ComponentMask aMask);
+        ~Archetype();
+
+        ComponentMask mask;
+        uint32_t chunkCapacity = 0; // entities per chunk
+        size_t entityCount = 0;
+
+        struct Chunk {
+            unsigned char* data = nullptr;
+            uint32_t count = 0;
+        };
+        std::vector<Chunk> chunks; // only the last one is ever partly full
+
+        // room for about count more entities (on top of earlier reserves) without allocating. chunks that empty out
+        // are kept for reuse instead of freed until there are enough for everything reserved
+        void reserve(size_t count);
+
+        bool has(ComponentMask required) const { return (mask & required) == required; }
+        Entity* entities(size_t chunk) const { return (Entity*)chunks[chunk].data; }
+        // nullptr if this archetype doesn't have it
+        void* column(size_t chunk, int component) const;
+        template<typename T>
+        T* column(size_t chunk) const { return (T*)column(chunk, componentId<T>()); }
+
+    private:
+        friend class World;
+        size_t offsets[ECS_MAX_COMPONENTS]; // where each component's array starts in a chunk
+        std::vector<unsigned char*> spareChunks; // empty, waiting to be reused
+        size_t reservedEntities = 0;
+        size_t reservedChunks() const;
+        // adds a row at the end with zeroed components, returns (chunk, row)
+        void push(Entity entity, uint32_t& chunk, uint32_t& row);
+        // moves the last row into (chunk, row), returns the entity that moved, NO_ENTITY if the removed row was the last
+        Entity removeSwap(uint32_t chunk, uint32_t row);
+};
+
+class World {
+    public:
+        World() = default;
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+        ~World();
+
+        Entity create(ComponentMask mask);
+        void destroy(Entity entity);
+        bool alive(Entity entity) const;
+        ComponentMask mask(Entity entity) const;
+        // moves the entity to the archetype for the new mask, components in both keep their values, new ones are zeroed
+        void setMask(Entity entity, ComponentMask newMask);
+        size_t count() const { return liveCount; }
+        // destroys everything and frees all the storage, reserves included. happens by itself when the last
+        // entity is destroyed, but only if nothing is reserved, a pool with every instance despawned still
+        // wants its room. whoever reserved calls this once they're done with it (the physics bench between runs)
+        void clear();
+        // so count more entities with this mask can be created without allocating, e.g. a pool (prefab.hpp)
+        void reserve(ComponentMask mask, size_t count);
+
+        // entity has to be alive and have a T
+        template<typename T>
+        T* get(Entity entity) const {
+            const Record& record = records[entity.index];
+            return (T*)record.archetype->column(record.chunk, componentId<T>()) + record.row;
+        }
+        template<typename T>
+        bool has(Entity entity) const { return (mask(entity) & componentMask<T>()) != 0; }
+
+        // every archetype with at least the components of required
+        template<typename F>
+        void eachArchetype(ComponentMask required, F&& fn) {
+            for (Archetype* archetype : archetypes)
+                if (archetype->entityCount > 0 && archetype->has(required)) fn(*archetype);
+        }
+        // fn(count, entities, Ts*...) once per chunk
+        template<typename... Ts, typename F>
+        void eachChunk(F&& fn) {
+            eachArchetype(componentMask<Ts...>(), [&](Archetype& archetype) {
+                for (size_t c = 0; c < archetype.chunks.size(); c++)
+                    fn((size_t)archetype.chunks[c].count, archetype.entities(c), archetype.column<Ts>(c)...);
+            });
+        }
+        // fn(entity, Ts&...) for every entity with all of Ts
+        template<typename... Ts, typename F>
+        void each(F&& fn) {
+            eachChunk<Ts...>([&](size_t count, Entity* entities, Ts*... columns) {
+                for (size_t i = 0; i < count; i++) fn(entities[i], columns[i]...);
+            });
+        }
+
+    private:
+        struct Record {
+            Archetype* archetype = nullptr; // nullptr while the slot is free
+            uint32_t chunk = 0, row = 0;
+            uint32_t generation = 0;
+        };
+        Archetype* archetypeFor(ComponentMask mask);
+        bool hasReserves() const;
+
+        std::vector<Archetype*> archetypes; // few of them, a linear search beats a map
+        std::vector<Record> records; // the slots, indexed by Entity::index
+        std::vector<uint32_t> freeSlots;
+        size_t liveCount = 0;
+        // clear() throws the slots away, new ones start past every generation handed out so far
+        // so handles from before the clear can't come back to life
+        uint32_t firstGeneration = 0;
+};
+
+#endif
@@ -6,28 +6,43 @@
 
 #include <math.h>
 #include <random>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/glm.hpp>
 
 #include "texture.hpp"
 #include "shader.hpp"
 #include "camera.hpp"
+#include "ecs.hpp"
+#include "scene_graph.hpp"
 
 class Element {
     public:
         unsigned int VAO = 0, VBO = 0, EBO = 0;
+        unsigned int depthVAO = 0, positionVBO = 0; // position only copy of the mesh for the depth pre-pass
+        bool sharedMesh = false; // the buffers and texture above belong to someone else (a Prefab), don't delete them
         glm::vec3 position{0.0f};
         glm::vec3 lastPosition{0.0f};
+        // position before the last physics step, and how far back toward it we get drawn this frame
+        // (interpolateElements in systems.hpp). set previousPosition along with position to teleport
+        glm::vec3 previousPosition{0.0f};
+        glm::vec3 renderOffset{0.0f};
         glm::vec3 velocity{0.0f};
         glm::vec3 holdVelocity{0.0f};
         bool wireframe = false;
         GLenum draw_mode = GL_TRIANGLES;
 
+        // only valid until init(), which uploads them and then frees them unless keepCpuMesh is set
         std::vector<float> vertices;
         std::vector<unsigned int> indices;
+        bool keepCpuMesh = false;
+        unsigned int indexCount = 0; // what gets drawn, set by init()
+        // box around the unrotated, unscaled mesh, set by init(). the bounding box gets rebuilt from this when we rotate
+        glm::vec3 localBoundsMin{0.0f}, localBoundsMax{0.0f};
         std::string textureFile = "";
         bool useTexture = false;
         Texture texture;
@@ -40,6 +55,8 @@ class Element {
         float pointLightLinear = 0.09f;
         float pointLightQuadratic = 0.032f; // 0.7f linear and 1.8 quadratic will cover a distance of ~7
         float pointLightSpecStrength = 0.5f;
+        bool pointLightShadows = true; // only the closest MAX_SHADOWED_POINT_LIGHTS actually get a shadow map
+        bool castShadow = true;
 
         // bounding_box_corner1 is min, bounding_box_corner2 is max
         // ALWAYS make sure min is lower (y position is less than) max
@@ -53,6 +70,15 @@ class Element {
         Camera* attachedCamera;
 
         int id = NAN;
+        Entity entity = NO_ENTITY; // in the world (systems.hpp), set by addToWorld
+        // the Objects list addToWorld put us in and where, so removeFromWorld doesn't have to search it
+        std::vector<Element*>* objects = nullptr;
+        size_t objectIndex = 0;
+        // our node in sceneGraph if we're in it (scene_graph.hpp). attached means a parent node moves us
+        // around instead of physics, sceneBasis is the orientation it gives us on top of rotation
+        SceneNodeId sceneNode = NO_SCENE_NODE;
+        bool attached = false;
+        glm::mat3 sceneBasis{1.0f};
 
         // PHYSICS
         // by default: all has collision, all can have velocity
@@ -65,31 +91,48 @@ class Element {
         bool gravity = true;
         bool holdable = true;
 
-        Element* debugElement = nullptr;
         bool debug = false;
         Element() = default;
 
         bool isPlayer = false;
 
-        bool rotate = false;
-        glm::vec3 rotateAxis = glm::vec3(0.0f, 1.0f, 0.0f); // what axis(es) to apply rotation to
-        float rotationSpeed = 0.0f; // the speed at which we rotate
         glm::vec3 pivot = glm::vec3(0.0f); // what point to rotate around
-        glm::vec3 rotation = glm::vec3(0.0f); // initial orientation
-        glm::vec3 pastRotation = glm::vec3(0.0f); // initial orientation
-
-        float currentAngle = 0.0f; // to track rotation over time
-
+        // orientation is what physics integrates angularVelocity (radians per second around each world axis) into,
+        // previousOrientation is from before the last step and renderOrientation is what we get drawn with,
+        // interpolated between the two like renderOffset. setRotation to place something
+        glm::quat orientation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::quat previousOrientation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::quat renderOrientation{1.0f, 0.0f, 0.0f, 0.0f};
+        glm::vec3 angularVelocity{0.0f};
+        // euler angles in radians, x then y then z. teleports, nothing interpolates from the old orientation
+        void setRotation(glm::vec3 euler);
+        // turns us from where we are now by euler (radians, around the world axes)
+        void rotateBy(glm::vec3 euler);
+
+        // drawing happens from the frame's RenderSnapshot (render_snapshot.hpp), which gets a copy of everything it needs
         void init();
-        void draw(const glm::mat4& view, const glm::mat4& projection, Element& lightSource, glm::vec3 cameraPos, float time) const;
         void update(float deltaTime);
+        // cached, the rotation/scale part only gets rebuilt when renderOrientation, size or sceneBasis changed
         glm::mat4 getMatrix(bool translate = true) const;
+        // rotation/scale like getMatrix(false), but from orientation (where physics has us) instead of the
+        // interpolated renderOrientation. what the bounding box gets fit to
+        glm::mat4 getBoundsMatrix() const;
+        // rebuilds bounding_box_corner1/2 around the local box turned by getBoundsMatrix(). without a local box
+        // there's nothing to turn and the corners stay as they are
+        void fitBounds();
+        // where we get drawn, somewhere between previousPosition and position
+        glm::vec3 renderPosition() const { return position + renderOffset; }
         bool getUseTexture() const;
-        void physics_step(float dt, std::vector<Element*>& Objects);
         ~Element();
         bool grounded = false; // only for player, check for if on ground and let player jump if so.
-
-        glm::uvec2 debugVAOVBO;
+    private:
+        // what getMatrix() built cachedRotationMatrix from, anything different means it's dirty
+        mutable glm::mat4 cachedRotationMatrix{1.0f};
+        mutable glm::quat cachedOrientation{1.0f, 0.0f, 0.0f, 0.0f};
+        mutable glm::vec3 cachedSize{0.0f};
+        mutable glm::mat3 cachedBasis{1.0f};
+        glm::quat boundsOrientation{1.0f, 0.0f, 0.0f, 0.0f}; // what the bounding box was last fit to
+        mutable bool matrixDirty = true;
 };
 
 
@@ -114,6 +157,8 @@ class HUDElement {
         HUDElement() = default;
 
         void init();
+        // re-send vertices and indices after changing them, for HUD stuff that changes every frame
+        void upload();
         void draw() const;
         void update(float deltaTime);
         bool getUseTexture() const;
@@ -128,8 +173,13 @@ class HUDElement {
         float currentAngle = 0.0f; // to track rotation over time
 };
 
-// returns id
+// returns id. also gives it an entity in the world, which it takes back out when it's destroyed
 int addToWorld(Element* e, std::vector<Element*>& Objects);
+// O(1), the last element in Objects gets moved into the hole so Objects stays dense but its order changes.
+// destroys the entity too, so handles to it stop being alive, and detaches it if something in the scene graph
+// was carrying it. the destructor does this by itself
+void removeFromWorld(Element* e);
 extern std::vector<Element*> PointLights;
-extern bool renderDebug;
+// debug lines (debug_draw.hpp) and every bounding box, toggled with P (toggle_debug)
+extern std::atomic<bool> renderDebug;
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef GPU_TIMERS_HPP
+#define GPU_TIMERS_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+
+// gpu side timing with GL_TIMESTAMP queries, a begin and end timestamp per zone.
+// each frame writes into its own set of queries and we only read a set back GPU_TIMER_FRAMES - 1 frames later,
+// by then the gpu is long done with it so reading never waits. the numbers you see are that many frames old.
+//
+//     gpuTimers.beginFrame();
+//     int zone = gpuTimers.begin("opaque");
+//     ...draws...
+//     gpuTimers.end(zone);
+//
+// names have to be string literals (or outlive the timers), same as the cpu profiler
+#define GPU_TIMER_FRAMES 4
+#define GPU_TIMER_MAX_ZONES 128 // per frame, begin() past this just returns -1
+
+struct GpuTimerResult {
+    const char* name;
+    double milliseconds;
+    uint64_t start, end; // gpu timestamps in nanoseconds
+};
+
+class GpuTimers {
+    public:
+        void init();
+        // reads back the oldest frame (if the gpu finished it) and starts recording a new one
+        void beginFrame();
+        int begin(const char* name);
+        void end(int zone);
+        ~GpuTimers();
+
+        // zones of the last frame that was read back, in the order they were begun
+        const std::vector<GpuTimerResult>& lastFrame() const { return results; }
+        // total of every zone with this name in lastFrame(), 0 if there wasn't one
+        double milliseconds(const char* name) const;
+        double frameMilliseconds = 0.0; // first begin to last end of lastFrame()
+        // frames that got dropped, because their queries weren't done in time or a zone in them was never end()ed
+        int missedReadbacks = 0;
+    private:
+        struct Frame {
+            unsigned int queries[GPU_TIMER_MAX_ZONES * 2] = {};
+            const char* names[GPU_TIMER_MAX_ZONES] = {};
+            bool ended[GPU_TIMER_MAX_ZONES] = {};
+            int count = 0;
+            int lastIssued = -1; // the query glQueryCounter was called on last, zones nest so it's not always the last end
+        };
+        void readBack(Frame& frame);
+
+        Frame frames[GPU_TIMER_FRAMES];
+        int frameIndex = 0;
+        bool initialized = false;
+        std::vector<GpuTimerResult> results;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef HUD_HPP
+#define HUD_HPP
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <glm/glm.hpp>
+
+#include "element.hpp"
+#include "renderer.hpp"
+
+// performance overlay in the top left, toggled with F3.
+// all the text (and the panel behind it) is one HUDElement using a built in 5x7 font atlas,
+// the frame time graph is a second HUDElement drawn as GL_LINES, so the whole thing is 2 draws.
+// the text only gets rebuilt a few times a second so it doesn't end up in the numbers it's showing
+#define HUD_GRAPH_SAMPLES 240
+#define HUD_TEXT_REFRESH 0.25f // seconds
+
+// what main measured this frame (the physics numbers come from the simulation's RenderSnapshot),
+// everything else comes from the renderer
+struct HudFrameInfo {
+    float frameTime = 0.0f; // seconds
+    float physicsTime = 0.0f; // seconds spent in the physics accumulator loop
+    int physicsSteps = 0;
+    int bodies = 0, awakeBodies = 0;
+    float inputAge = -1.0f; // seconds from the newest mouse event to submitting the view it's in, -1 if none new
+    uint64_t heapAllocations = 0; // operator new calls over the last frame, see memory_tracking.hpp
+};
+
+class PerfHud {
+    public:
+        void init();
+        void update(const HudFrameInfo& frame, const Renderer& renderer, int width, int height);
+        // draws on top of whatever is bound, expects update() to have been called this frame
+        void draw() const;
+    private:
+        void rebuildText(const Renderer& renderer, int width, int height);
+        void rebuildGraph(int width, int height);
+        void addQuad(glm::vec2 pixelMin, glm::vec2 pixelMax, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec3 color, int width, int height);
+        void addText(const char* text, glm::vec2 pixelPos, glm::vec3 color, int width, int height);
+
+        HUDElement text;
+        HUDElement graph;
+        float frameTimes[HUD_GRAPH_SAMPLES] = {}; // ring buffer, seconds
+        int frameCursor = 0;
+        int frameCount = 0;
+        float sinceRefresh = HUD_TEXT_REFRESH;
+        float physicsTime = 0.0f; // averaged over the refresh interval
+        int physicsSteps = 0, refreshFrames = 0;
+        uint64_t heapAllocations = 0; // most in a single frame over the refresh interval
+        int bodies = 0, awakeBodies = 0; // latest
+        float inputAge = 0.0f; // summed over the refresh interval's inputFrames frames that had new mouse movement
+        int inputFrames = 0;
+        std::vector<float> sorted; // scratch for the percentiles
+};
+
+// toggled with F3
+extern std::atomic<bool> showPerfHud;
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "util.hpp"
+
+// input goes: glfw callbacks -> InputQueue (timestamped events, main thread) -> main's sampleInput turns the
+// queue into held keys + mouse movement for the simulation (and the replay file) -> keys[] -> ActionState
+// through the InputBindings. gameplay code only asks about actions, so what key does what can be rebound
+// (--bind jump=space) without touching it
+
+enum class Action {
+    MoveForward, MoveBack, MoveLeft, MoveRight, Jump,
+    Pickup, Rocket, RotateX, RotateY, RotateZ,
+    ToggleDebug, ToggleDeferred, TogglePrepass, DumpTrace, TogglePerfHud, MemoryReport,
+    ReleaseMouse, // main thread only, the simulation never sees it
+    Count
+};
+#define ACTION_COUNT ((int)Action::Count)
+#define MOUSE_SENSITIVITY 0.1f // degrees per pixel of cursor movement
+
+const char* actionName(Action action);
+
+class InputBindings {
+    public:
+        InputBindings(); // the default keys, WASD etc
+        void bind(Action action, int key);
+        int key(Action action) const { return keys[(int)action]; }
+        // "action=key" like "jump=space", "pickup=q" or "rocket=70". key is a single character, a name
+        // (space, escape, enter, tab, f1-f12) or a glfw key code. false (and nothing changes) if it can't be read
+        bool parse(const char* binding);
+        // every key bound to something, each once, in action order. bit i of a live or recorded key mask is keys[i]
+        std::vector<int> boundKeys() const;
+    private:
+        int keys[ACTION_COUNT];
+};
+extern InputBindings inputBindings;
+
+struct InputEvent {
+    enum Type { Key, MouseMove };
+    Type type;
+    double time; // glfwGetTime() when the callback ran
+    int key; // Key
+    bool pressed; // Key, false for a release
+    glm::vec2 delta; // MouseMove, raw cursor movement in pixels
+};
+
+// filled by the glfw callbacks during glfwPollEvents, emptied by whoever drains it, both on the main thread.
+// keeps its storage, so it stops allocating after the first busy frame
+class InputQueue {
+    public:
+        void push(const InputEvent& event) { events.push_back(event); }
+        template<typename F>
+        void drain(F&& fn) {
+            for (const InputEvent& event : events) fn(event);
+            events.clear();
+        }
+    private:
+        std::vector<InputEvent> events;
+};
+
+// the simulation's view of the actions this frame, from keys[] (live or replayed) through the bindings
+struct ActionState {
+    bool held[ACTION_COUNT] = {};
+    bool pressed[ACTION_COUNT] = {}; // went down this frame
+    bool down(Action action) const { return held[(int)action]; }
+    bool justPressed(Action action) const { return pressed[(int)action]; }
+};
+void updateActions(ActionState& actions, const KeyState keys[512], const InputBindings& bindings);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef LIGHTING_HPP
+#define LIGHTING_HPP
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+#include "render_snapshot.hpp"
+
+// clustered forward lighting
+// the view frustum is cut into a CLUSTER_X * CLUSTER_Y * CLUSTER_Z grid (screen tiles, and exponential depth slices)
+// every frame each point light is assigned to the clusters its attenuation range touches, and
+// object.frag only loops over the lights in the cluster the fragment is in instead of every light in the scene
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+
+// once light*attenuation falls below this we treat the light as having no effect, this decides a lights range
+#define LIGHT_CUTOFF (5.0f / 256.0f)
+
+// has to match PointLight in shaders/object.frag (std430)
+struct GpuPointLight {
+    glm::vec4 positionRange; // xyz position, w range
+    glm::vec4 colorSpec;     // rgb color, a specular strength
+    glm::vec4 attenuation;   // x constant, y linear, z quadratic, w shadow slot (-1 for none)
+};
+
+// how far a light reaches before its contribution drops under LIGHT_CUTOFF
+float calcLightRange(const ElementDrawState& light);
+
+class LightClusters {
+    public:
+        void init();
+        // assigns lights to clusters and uploads everything, call once per frame before drawing
+        void update(const std::vector<ElementDrawState*>& lights, const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar);
+        // binds the light buffers and sets the uniforms object.frag needs to find its cluster
+        void bind(Shader& shader, float screenWidth, float screenHeight) const;
+        ~LightClusters();
+
+        unsigned int lightSSBO = 0, clusterSSBO = 0, indexSSBO = 0;
+        size_t lightCount = 0;
+        size_t assignedCount = 0; // total light/cluster pairs this frame
+    private:
+        void buildClusterBounds(const glm::mat4& projection);
+        int sliceFromDepth(float depth) const;
+
+        float zNear = 0.1f, zFar = 100.0f;
+        glm::mat4 lastProjection{0.0f};
+
+        // view space cluster bounds, one array per component so a row of the sphere test reads each in order
+        std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+        // reused every frame so we don't allocate while assigning
+        std::vector<GpuPointLight> gpuLights;
+        std::vector<glm::uvec2> pairs;         // (cluster, light)
+        std::vector<glm::uvec2> clusterRanges; // (offset, count) per cluster
+        std::vector<unsigned int> lightIndices;
+        size_t reservedLights = 0; // the vectors above have room for this many lights in every cluster
+        size_t lightCapacity = 0, indexCapacity = 0;
+};
+
+#endif
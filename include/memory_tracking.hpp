@@ -0,0 +1,98 @@
+#ifndef MEMORY_TRACKING_HPP
+#define MEMORY_TRACKING_HPP
+
+#include <stdio.h>
+#include <cstddef>
+#include <cstdint>
+
+// who is using how much memory. every operator new gets charged to whatever tag is current on that thread,
+// and GL buffers/textures get charged when they're created, so both cpu and gpu side add up per subsystem:
+//
+//     void Texture::init(...) {
+//         MEMORY_TAG(MemoryTag::Textures); // everything new'd until the end of the scope counts as Textures
+//         ...
+//         trackGpuObject(GpuObjectKind::Texture, texture, width * height * 4, MemoryTag::Textures);
+//     }
+//
+// printMemoryReport() prints live numbers (F4 in game), printLeakReport() runs at shutdown and lists what's
+// still alive after everything should have been freed.
+// the GL driver's own allocations (mesa's llvm is C++) get charged to whoever made the GL call, so a driver
+// cache that lives until exit can show up as a small leak under e.g. textures.
+// only compiled in with NGENFESH_PROFILE like the profiler, in release builds the tag macro is empty and
+// the functions do nothing. costs 16 bytes of header per allocation when it is on.
+//
+// the gpu side is main thread only, same as GL, and asserts that.
+
+enum class MemoryTag : uint8_t {
+    General, // anything nobody tagged
+    Meshes, // vertex/index data, cpu copies and GL buffers
+    Textures,
+    Physics,
+    Debug, // bounding box wireframes, debug lines
+    Renderer, // G-buffer, draw lists, queries
+    Lighting, // light clusters
+    Shadows,
+    Hud,
+    Profiler,
+    Count
+};
+
+enum class GpuObjectKind : uint8_t {
+    Buffer,
+    Texture,
+    Renderbuffer
+};
+
+struct MemoryTagStats {
+    int64_t heapBytes = 0; // live right now
+    int64_t heapPeak = 0; // not filled in by memoryTotals, peaks of different tags don't add up
+    int64_t heapAllocations = 0; // live allocations right now
+    int64_t gpuBytes = 0;
+    int64_t gpuObjects = 0;
+};
+
+const char* memoryTagName(MemoryTag tag);
+MemoryTagStats memoryStats(MemoryTag tag);
+// every tag added up
+MemoryTagStats memoryTotals();
+
+// how many times operator new has been called since startup, diff it across a frame to see what
+// that frame allocated. a steady state frame should come out at 0
+uint64_t heapAllocations();
+
+// calling it again for the same object replaces the old size (glBufferData on an existing buffer)
+void trackGpuObject(GpuObjectKind kind, unsigned int id, size_t bytes, MemoryTag tag);
+void untrackGpuObject(GpuObjectKind kind, unsigned int id);
+// bytes of a width x height 2D image (times layers for arrays/cubes), mip chain included if mipmapped
+size_t textureBytes(int width, int height, int layers, int bytesPerTexel, bool mipmapped);
+
+// true on the thread main() runs on, the one with the GL context. works in release builds too
+bool onMainThread();
+
+void printMemoryReport(FILE* file = stdout);
+// remembers what's alive right now, the leak report only complains about heap memory allocated after this
+// (main calls it once everything static is set up) plus any GL object that was never deleted
+void memoryCheckpoint();
+void printLeakReport();
+
+#ifdef NGENFESH_PROFILE
+
+class MemoryScope {
+    public:
+        explicit MemoryScope(MemoryTag tag);
+        ~MemoryScope();
+    private:
+        MemoryTag previous;
+};
+
+#define MEMORY_CONCAT_INNER(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_INNER(a, b)
+#define MEMORY_TAG(tag) MemoryScope MEMORY_CONCAT(memoryScope, __LINE__)(tag)
+
+#else
+
+#define MEMORY_TAG(tag)
+
+#endif
+
+#endif
@@ -7,6 +7,7 @@
 #include "util.hpp"
 #include "element.hpp"
 #include "premade_elements.hpp"
+#include "input.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -19,8 +20,9 @@ class Player {
         Camera* camera() {
             return attachedCamera;
         }
-        // keyInput() will go through it's binds, move or do whatever if needed 
-        void keyInput(float deltaTime, KeyState keys[512], GLFWwindow* window);
+        // keyInput() will go through the actions, move or do whatever if needed. runs on the simulation side,
+        // so no glfw calls in here (releasing the mouse is main's sampleInput)
+        void keyInput(float deltaTime, const ActionState& actions);
         void orient(float yaw, float pitch);
         float getSpeed() {
             return playerState.speed;
@@ -33,7 +35,10 @@ class Player {
         }
         void setPosition(glm::vec3 pos) {
             playerElement.position = pos;
+            playerElement.previousPosition = pos; // teleport, don't interpolate across the map
         }
+        // puts the camera where the player gets drawn this frame, after interpolateElements
+        void updateCamera();
         void setVelocity(glm::vec3 aVelocity) {playerElement.velocity = aVelocity;}
         void setVelocityX(float x) {playerElement.velocity.x = x;}
         void setVelocityY(float y) {playerElement.velocity.y = y;}
@@ -64,9 +69,13 @@ class Player {
             glm::vec3 cameraOrientation;
             float speed = 5.0f;
             float jumpPower = 2.5f;
-            bool holdingSomething;
-            Element* heldElement;
+            bool holdingSomething = false;
+            Entity heldEntity = NO_ENTITY; // not an Element*, whatever we hold can get removed out from under us
         };
+        // in sceneGraph: where the camera is looking from, and the point in front of it held things are attached to
+        SceneNodeId viewNode = NO_SCENE_NODE, holdNode = NO_SCENE_NODE;
+        // what we're holding, nullptr (and we stop holding) if it's gone
+        Element* heldElement();
         state playerState; // do not edit playerstate.pos/vel, this is only for reading
         std::vector<Element*>* WorldObjects;
 };
@@ -0,0 +1,61 @@
+#ifndef PREFAB_HPP
+#define PREFAB_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "element.hpp"
+#include "ecs.hpp"
+
+// pooled copies of one Element for things that come and go by the thousand (bullets, debris, ...).
+// init() uploads the mesh once and makes every instance up front, the instances share the mesh's buffers
+// and texture, and the world and Objects have room for all of them, so spawn/despawn never touch GL or the
+// heap. that holds as long as whatever else gets added to Objects after init() was reserved for too:
+//
+//     Prefab bullet;
+//     bullet.base.vertices = {CUBE_VERTICES}; bullet.base.indices = {CUBE_INDICES};
+//     bullet.base.shader = objectShader; bullet.base.gravity = false;
+//     bullet.init(2048, Objects);
+//     ...
+//     SpawnTransform shot{muzzle, forward * 80.0f};
+//     Entity spawned;
+//     spawn(bullet, 1, &shot, Objects, &spawned);
+//     ...
+//     despawn(bullet, spawned);
+//
+// instances are plain Elements in Objects like everything else, hold on to their Entity rather than the
+// Element* since a despawned instance gets handed out again. a base without a mesh is physics only and
+// nothing gets uploaded (the headless bench). point lights don't get pooled.
+// the room reserved in the world stays after the Prefab is gone, world.clear() gives it back.
+struct SpawnTransform {
+    glm::vec3 position{0.0f};
+    glm::vec3 velocity{0.0f};
+    glm::quat orientation{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec3 angularVelocity{0.0f};
+};
+
+class Prefab {
+    public:
+        Prefab() = default;
+        Prefab(const Prefab&) = delete;
+        Prefab& operator=(const Prefab&) = delete;
+
+        Element base; // set up like any Element, but don't init() it or add it to the world
+        // Objects is what the instances will be spawned into
+        void init(size_t capacity, std::vector<Element*>& Objects);
+        size_t capacity() const { return instances.size(); }
+        size_t active() const { return instances.size() - freeInstances.size(); }
+
+        std::vector<Element> instances; // never resized after init(), so pointers into it stay good
+        std::vector<uint32_t> freeInstances; // indices into instances, spawn takes from the back
+};
+
+// spawns up to count instances into Objects, one per transform. returns how many it spawned, fewer than count
+// only if the pool ran out. spawned (if given) gets the entity of each one
+size_t spawn(Prefab& prefab, size_t count, const SpawnTransform* transforms, std::vector<Element*>& Objects, Entity* spawned = nullptr);
+// false if it isn't alive or isn't one of this prefab's
+bool despawn(Prefab& prefab, Entity entity);
+void despawnAll(Prefab& prefab);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// cpu profiler, zones get recorded into a ring buffer per thread and can be dumped as a chrome trace
+// (open it in chrome://tracing or ui.perfetto.dev)
+//
+//     void Thing::update() {
+//         PROFILE_FUNCTION();
+//         { PROFILE_SCOPE("expensive part"); ... }
+//     }
+//
+// names have to outlive the profiler (string literals), only the pointer gets stored.
+// everything here is only compiled in with NGENFESH_PROFILE (the Makefile sets it unless RELEASE=1),
+// otherwise the macros are empty and none of this exists.
+
+#ifdef NGENFESH_PROFILE
+
+#include <atomic>
+#include <cstdint>
+
+#define PROFILE_RING_SIZE 65536 // zones kept per thread, older ones get overwritten
+
+namespace profiler {
+    struct Zone {
+        const char* name;
+        uint64_t start; // nanoseconds since the profiler started
+        uint64_t end;
+    };
+
+    // only the owning thread ever writes, so recording a zone needs no locks,
+    // head is atomic so a dump from another thread sees whole zones
+    struct ThreadBuffer {
+        Zone zones[PROFILE_RING_SIZE];
+        std::atomic<uint64_t> head{0};
+        const char* threadName = nullptr;
+        int threadId = 0;
+        bool timeline = false; // see timelineBuffer
+    };
+
+    uint64_t now();
+    ThreadBuffer& threadBuffer();
+    void setThreadName(const char* name);
+    // a track in the trace that isn't a thread (the gpu timers use one), only one thread should record into it
+    ThreadBuffer& timelineBuffer(const char* name);
+
+    inline void record(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end) {
+        uint64_t index = buffer.head.load(std::memory_order_relaxed);
+        buffer.zones[index % PROFILE_RING_SIZE] = Zone{name, start, end};
+        buffer.head.store(index + 1, std::memory_order_release);
+    }
+    // writes every thread's recorded zones to path as chrome trace json, false if the file couldn't be opened
+    bool writeTrace(const char* path);
+
+    class Scope {
+        public:
+            Scope(const char* aName) : name(aName), start(now()) {}
+            ~Scope() {
+                record(threadBuffer(), name, start, now());
+            }
+        private:
+            const char* name;
+            uint64_t start;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD_NAME(name) profiler::setThreadName(name)
+#define PROFILE_DUMP(path) profiler::writeTrace(path)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_DUMP(path)
+
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef RENDER_SNAPSHOT_HPP
+#define RENDER_SNAPSHOT_HPP
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+#include "element.hpp"
+#include "camera.hpp"
+
+// everything the renderer needs from the simulation for one frame, copied out at the end of the sim frame.
+// the renderer only ever draws from a snapshot, so with --threaded the simulation can already be working on
+// the next frame on its own thread while this one is being submitted.
+// that includes meshes, flags and light parameters, not just what moves: the render side never reads an
+// Element, the simulation is free to spawn, despawn, attach or change anything while a frame is drawn.
+// GL names are fine to copy, Elements only get destroyed on the main thread (~Element asserts it), which is
+// the render thread, so never while a frame is being drawn with their buffers.
+struct ElementDrawState {
+    const Element* element; // who this is, to recognize it again next frame (shadow casters, light slots). never read through
+    glm::mat4 matrix;
+    glm::vec3 position; // renderPosition(), interpolated
+    glm::vec3 min, max; // world space bounding box around position
+
+    unsigned int VAO, EBO, depthVAO;
+    unsigned int indexCount;
+    GLenum drawMode;
+    Shader* shader;
+    bool useTexture;
+    unsigned int texture;
+    GLenum textureTarget;
+    bool wireframe, debug, hasCollision, isPlayer, castShadow;
+
+    // point lights only
+    glm::vec3 pointLightColor;
+    float pointLightConstant, pointLightLinear, pointLightQuadratic, pointLightSpecStrength;
+    bool pointLightShadows;
+    int shadowSlot; // render side, ShadowMaps hands these out every frame
+
+    // shaderOverride draws with a different shader than our own, e.g. the G-buffer shader
+    void draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, Shader* shaderOverride = nullptr) const;
+    // depth only draw, depthShader needs to be in use with view/projection already set
+    void drawDepth(Shader& depthShader) const;
+};
+
+struct RenderSnapshot {
+    std::vector<ElementDrawState> states; // one per Objects entry
+    std::vector<ElementDrawState*> lights; // PointLights, they have to be in Objects too. point into states
+    Camera camera;
+    glm::dvec2 mouseTaken{0.0}; // how much mouse movement the simulation had taken in total, for main's latchCamera
+    // for the HUD
+    float physicsTime = 0.0f;
+    int physicsSteps = 0;
+    int bodies = 0, awakeBodies = 0;
+};
+
+// sim side, reuses the snapshot's vectors so there's nothing to allocate once they're big enough
+void captureSnapshot(RenderSnapshot& snapshot, const std::vector<Element*>& Objects, const std::vector<Element*>& lights, const Camera& camera);
+
+// three snapshots: the one the simulation is writing, the newest finished one, and the one being drawn.
+// publishing and acquiring only swap indices under a lock. the simulation stays at most one frame ahead,
+// publish() waits until the renderer has picked up what it published, and acquire() waits for something new
+class SnapshotBuffer {
+    public:
+        RenderSnapshot& writing() { return buffers[writeIndex]; }
+        // false if the buffer was closed while waiting
+        bool publish();
+        // newest published snapshot, nullptr once closed with nothing new left. the render side may change it
+        // (latchCamera does) until the next acquire
+        RenderSnapshot* acquire();
+        // wakes up and stops both sides, when the window closes or a replay runs out
+        void close();
+    private:
+        RenderSnapshot buffers[3];
+        int writeIndex = 0, readyIndex = 1, readIndex = 2;
+        bool fresh = false; // readyIndex has something acquire() hasn't taken yet
+        bool closed = false;
+        std::mutex mutex;
+        std::condition_variable changed;
+};
+
+#endif
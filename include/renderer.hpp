@@ -0,0 +1,96 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include <vector>
+#include <atomic>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "element.hpp"
+#include "camera.hpp"
+#include "lighting.hpp"
+#include "shadows.hpp"
+#include "skybox.hpp"
+#include "gpu_timers.hpp"
+#include "render_snapshot.hpp"
+
+// G-buffer for the deferred path, 12 bytes a pixel:
+// RG16_SNORM octahedral normal, RGBA8 albedo, and depth (position gets rebuilt from depth)
+class GBuffer {
+    public:
+        unsigned int FBO = 0;
+        unsigned int normalTexture = 0, albedoTexture = 0, depthTexture = 0;
+        int width = 0, height = 0;
+
+        void init(int aWidth, int aHeight); // also used to resize
+        void bindTextures() const; // normal -> unit 0, albedo -> unit 1, depth -> unit 2
+        ~GBuffer();
+    private:
+        void release();
+};
+
+#define SAMPLE_QUERY_COUNT 3
+
+struct RenderStats {
+    int drawCalls = 0;
+    int depthDrawCalls = 0; // pre-pass draws, counted separately
+    int triangles = 0;
+    int stateChanges = 0; // program, texture or VAO switches between consecutive element draws
+    // fragments that passed the depth test in the opaque pass (read back a couple frames late)
+    // without the pre-pass this is every fragment we shaded, so shadedSamples / pixels is the overdraw
+    unsigned long long shadedSamples = 0;
+    float overdraw = 0.0f;
+};
+
+class Renderer {
+    public:
+        void init(int width, int height);
+        // draws every element in the snapshot, forward or deferred depending on renderDeferred.
+        // also draws everything debugDraw collected this frame, plus every bounding box if renderDebug is on
+        void render(const RenderSnapshot& snapshot, int width, int height, float deltaTime);
+
+        unsigned int outputFBO = 0; // where the final image ends up, 0 is the window
+        float fov = 75.0f;
+        float zNear = 0.1f, zFar = 100.0f;
+        LightClusters lightClusters;
+        ShadowMaps shadows;
+        DirectionalLight sun;
+        Skybox skybox; // drawn if it was given a cubemap
+        GpuTimers gpuTimers; // one zone per pass, see gpu_timers.hpp
+        bool timeEachDraw = false; // also put a gpu zone around every opaque draw, costs 2 queries a draw
+        GBuffer gbuffer;
+        RenderStats stats;
+        ~Renderer();
+    private:
+        void forwardPass(const std::vector<ElementDrawState>& states, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, int width, int height);
+        void deferredPass(const std::vector<ElementDrawState>& states, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, int width, int height);
+        // sorts everything that was init()'d into opaque (front to back) and everything else
+        void buildDrawLists(const std::vector<ElementDrawState>& states, glm::vec3 cameraPos);
+        // opaque geometry, with the depth pre-pass first if it's on
+        void opaquePass(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, Shader* shaderOverride);
+        void readSampleQuery(int width, int height);
+        void countStateChanges(const ElementDrawState* e, const Shader* shader);
+
+        std::vector<const ElementDrawState*> opaque; // lit by objectShader, sorted front to back
+        std::vector<const ElementDrawState*> unlit; // debug boxes, light cubes, drawn in insertion order after
+        std::vector<std::pair<float, const ElementDrawState*>> sortKeys;
+        unsigned int lastProgram = 0, lastTexture = 0, lastVAO = 0; // what the previous draw used, for stats.stateChanges
+
+        // GL_SAMPLES_PASSED queries, we read the oldest one so we never wait on the gpu
+        unsigned int sampleQueries[SAMPLE_QUERY_COUNT] = {};
+        int sampleQueryFrame = 0;
+
+        unsigned int emptyVAO = 0; // core profile wants a VAO bound even for the bufferless fullscreen triangle
+
+        // average frame time/overdraw of the current path, printed when switching so they can be compared
+        bool lastDeferred = false, lastDepthPrepass = false;
+        float modeFrameTime = 0.0f, modeOverdraw = 0.0f, modeGpuTime = 0.0f;
+        int modeFrames = 0;
+};
+
+// toggled with G
+extern std::atomic<bool> renderDeferred;
+// depth only pass before the opaque pass, then shade with GL_EQUAL so every pixel is shaded once. toggled with Z
+extern std::atomic<bool> renderDepthPrepass;
+
+#endif
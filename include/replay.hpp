@@ -0,0 +1,48 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+// records what the player did each frame (keys, mouse movement, deltaTime) so a session can be played back
+// exactly, with the same deltaTimes, no matter how fast the machine runs it. good for A/B testing changes.
+//
+// file layout (little endian, it's only meant to be read back on the same kind of machine):
+//     "NGFR", uint32 version, uint32 keyCount, int32 keyCodes[keyCount]
+//     then per frame: float deltaTime, float mouseDX, float mouseDY, uint64 keyMask (bit i = keyCodes[i] held)
+#define REPLAY_VERSION 1
+#define REPLAY_MAX_KEYS 64
+
+struct InputFrame {
+    float deltaTime = 0.0f;
+    glm::vec2 mouseDelta{0.0f}; // raw cursor movement, before sensitivity
+    uint64_t keyMask = 0;
+};
+
+class InputRecorder {
+    public:
+        // keyCodes is the list of keys the mask bits refer to, 0 entries are skipped
+        bool startRecording(const char* path, const int* keyCodes, int keyCount);
+        bool startReplay(const char* path);
+        void recordFrame(const InputFrame& frame);
+        // false once the recording runs out
+        bool nextFrame(InputFrame& frame);
+        void close();
+        ~InputRecorder() { close(); }
+
+        bool recording() const { return file && !replayMode; }
+        bool replaying() const { return file && replayMode; }
+        // the key codes the current file's mask bits refer to
+        std::vector<int> keyCodes;
+        int frames = 0;
+    private:
+        FILE* file = nullptr;
+        bool replayMode = false;
+};
+
+// p50/p95/p99 of a set of per frame timings (seconds), printed in ms
+void printPercentiles(const char* label, std::vector<float>& samples);
+
+#endif
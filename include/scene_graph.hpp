@@ -0,0 +1,94 @@
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Element;
+
+// transform hierarchy. every node has a local transform (relative to its parent) and a world transform
+// (parent world * local). nodes live breadth first in plain arrays: roots first, then everything one level
+// down, and so on, with each node's children next to each other. so a parent always comes before its
+// children and a whole level can be walked straight through memory.
+//
+// setLocal only marks the node dirty, update() then recomputes the dirty nodes and everything under them and
+// nothing else, so a big scene where one arm moves costs that arm. changing the shape of the tree (create,
+// destroy, setParent) re-lays out the arrays on the next update(), that's O(nodes), don't do it every frame.
+//
+// nodes are handed out as ids that stay put when the layout changes. an id is only good until it's destroyed
+typedef uint32_t SceneNodeId;
+#define NO_SCENE_NODE 0xFFFFFFFFu
+
+class SceneGraph {
+    public:
+        SceneNodeId create(SceneNodeId parent = NO_SCENE_NODE);
+        // children are kept, they become roots and stay where they are in the world
+        void destroy(SceneNodeId node);
+        // NO_SCENE_NODE makes it a root. the local transform is kept, so it moves with its new parent
+        void setParent(SceneNodeId node, SceneNodeId parent);
+        SceneNodeId parent(SceneNodeId node) const { return parentOf[node]; }
+        bool alive(SceneNodeId node) const { return node < slots.size() && slots[node] != DEAD; }
+
+        void setLocal(SceneNodeId node, const glm::mat4& local);
+        const glm::mat4& local(SceneNodeId node) const { return locals[slots[node]]; }
+        // as of the last update()
+        const glm::mat4& world(SceneNodeId node) const { return worlds[slots[node]]; }
+
+        // an Element the node moves around, see attachElement
+        void setElement(SceneNodeId node, Element* e) { elements[slots[node]] = e; }
+        Element* element(SceneNodeId node) const { return elements[slots[node]]; }
+
+        void update();
+        size_t size() const { return liveNodes; }
+        size_t updatedNodes = 0; // how many world transforms the last update() recomputed
+
+        // fn(id, element) for every node with an Element, in breadth first order
+        template<typename F>
+        void eachElement(F&& fn) {
+            for (uint32_t i = 0; i < order.size(); i++)
+                if (elements[i]) fn(order[i], elements[i]);
+        }
+
+    private:
+        static constexpr uint32_t DEAD = 0xFFFFFFFFu;
+        void layout();
+
+        // by id
+        std::vector<uint32_t> slots; // where the id is in the breadth first arrays, DEAD if free
+        std::vector<SceneNodeId> parentOf;
+        std::vector<SceneNodeId> freeIds;
+
+        // breadth first. created nodes go on the end and destroyed ones leave a DEAD hole in order until layout()
+        std::vector<SceneNodeId> order; // the id at each position
+        std::vector<uint32_t> parentIndex; // DEAD for roots
+        std::vector<uint32_t> firstChild, childCount;
+        std::vector<glm::mat4> locals, worlds;
+        std::vector<Element*> elements;
+        std::vector<uint8_t> dirtyFlags; // already in dirty
+        std::vector<uint32_t> visited; // updateStamp when last recomputed
+
+        std::vector<SceneNodeId> dirty; // setLocal'd since the last update
+        std::vector<uint32_t> walk; // scratch for update()
+        uint32_t updateStamp = 0;
+        size_t liveNodes = 0;
+        bool layoutDirty = false;
+};
+
+// the game's graph, like world in systems.hpp
+extern SceneGraph sceneGraph;
+
+// e follows parent from now on, local is where it sits relative to it. its position and, on top of its own
+// rotation, its orientation come from the graph (updateSceneGraph), so physics treats it as kinematic:
+// it still gets collided with but gravity and velocity don't move it
+void attachElement(Element* e, SceneNodeId parent, const glm::mat4& local);
+// back to being a normal physics object, stays where it is in the world
+void detachElement(Element* e);
+// a node that follows e, to hang other things off it. e itself keeps being moved by physics
+SceneNodeId elementNode(Element* e);
+// once a frame after the elements and camera moved: feeds the root elements' matrices in, updates the dirty
+// subtrees and moves the attached elements to where the graph put them
+void updateSceneGraph();
+
+#endif
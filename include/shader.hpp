@@ -12,10 +12,13 @@ class Shader {
         unsigned int ID;
         Shader(std::string vertexShaderFile, std::string fragmentShaderFile);
         void use();
-        void setMat4(const std::string &name, const glm::mat4 &value) const;
-        void setInt(const std::string &name, const int &value) const;
-        void setVec3(const std::string &name, const glm::vec3 &value) const;
-        void setFloat(const std::string &name, const float &value) const;
+        // names are plain C strings so setting a uniform every frame doesn't build a std::string each time
+        void setMat4(const char* name, const glm::mat4 &value) const;
+        void setInt(const char* name, const int &value) const;
+        void setVec3(const char* name, const glm::vec3 &value) const;
+        void setFloat(const char* name, const float &value) const;
+        void setVec2(const char* name, const glm::vec2 &value) const;
+        void setIVec3(const char* name, const glm::ivec3 &value) const;
 };
 
 #endif
\ No newline at end of file
@@ -5,6 +5,12 @@
 extern Shader* objectShader;
 extern Shader* lightShader;
 extern Shader* debugShader;
+extern Shader* gbufferShader;
+extern Shader* deferredShader;
+extern Shader* depthShader;
+extern Shader* pointShadowShader;
+extern Shader* skyboxShader;
+extern Shader* hudShader;
 void initShaders();
 
 #endif
\ No newline at end of file
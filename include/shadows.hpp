@@ -0,0 +1,91 @@
+#ifndef SHADOWS_HPP
+#define SHADOWS_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "render_snapshot.hpp"
+#include "shader.hpp"
+
+// cascaded shadow maps for the sun, and cube shadow maps for the closest point lights
+// nothing gets re-rendered unless it has to: a map is only redrawn when its light moved, its cascade moved
+// or a caster inside its volume moved. anchored stuff never moves, so a scene that's mostly static costs close to nothing.
+// on top of that at most SHADOW_UPDATE_BUDGET views (a cascade or one cube face) get rendered per frame,
+// anything over budget just waits for the next frame
+#define SHADOW_CASCADES 3
+#define CASCADE_RESOLUTION 1024
+#define MAX_SHADOWED_POINT_LIGHTS 8
+#define POINT_SHADOW_RESOLUTION 256
+#define SHADOW_UPDATE_BUDGET 8
+
+struct DirectionalLight {
+    glm::vec3 direction = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+    glm::vec3 color = glm::vec3(0.0f); // black means off
+    bool castShadows = true;
+};
+
+struct ShadowStats {
+    int viewsRendered = 0; // cascades + cube faces redrawn this frame
+    int viewsPending = 0; // dirty views left over because of the budget
+    int casterDraws = 0;
+};
+
+class ShadowMaps {
+    public:
+        void init();
+        // figures out what's dirty and re-renders as much of it as the budget allows
+        // also hands out shadow slots to the closest point lights (ElementDrawState::shadowSlot)
+        void update(const std::vector<ElementDrawState>& states, const std::vector<ElementDrawState*>& lights, const DirectionalLight& sun,
+                    const glm::mat4& view, float fov, float aspect, float zNear, float zFar, glm::vec3 cameraPos);
+        // shadow maps go on texture units 3 and 4, the rest is uniforms used by lighting.glsl
+        void bind(Shader& shader, const DirectionalLight& sun) const;
+        ~ShadowMaps();
+
+        float cascadeSplits[SHADOW_CASCADES + 1]; // view space depths the cascades cover
+        ShadowStats stats;
+    private:
+        struct Cascade {
+            glm::mat4 wantedMatrix{1.0f}; // where the cascade should be this frame
+            glm::mat4 renderedMatrix{1.0f}; // what's actually in the texture, this is what the shader uses
+            glm::vec3 center{0.0f};
+            float radius = 0.0f;
+            bool dirty = true;
+        };
+        struct PointShadow {
+            const Element* light = nullptr; // who has the slot, only ever compared
+            ElementDrawState* state = nullptr; // that light in this frame's snapshot
+            glm::vec3 renderedPosition{0.0f};
+            float range = 0.0f;
+            unsigned char pendingFaces = 0x3F; // one bit per cube face that still has to be redrawn
+        };
+
+        void fitCascades(const DirectionalLight& sun, const glm::mat4& view, float fov, float aspect, float zNear, float zFar);
+        void assignPointSlots(const std::vector<ElementDrawState*>& lights, glm::vec3 cameraPos);
+        void findMovedCasters(const std::vector<ElementDrawState>& states);
+        void renderCascade(int index, const std::vector<ElementDrawState>& states, const DirectionalLight& sun);
+        void renderCubeFace(int slot, int face, const std::vector<ElementDrawState>& states);
+        bool isCaster(const ElementDrawState& e) const;
+
+        unsigned int FBO = 0;
+        unsigned int cascadeTexture = 0; // GL_TEXTURE_2D_ARRAY, one layer per cascade
+        unsigned int cubeTexture = 0; // GL_TEXTURE_CUBE_MAP_ARRAY, 6 layers per slot
+        Cascade cascades[SHADOW_CASCADES];
+        PointShadow pointShadows[MAX_SHADOWED_POINT_LIGHTS];
+        glm::vec3 lastSunDirection{0.0f};
+
+        // model matrix and world bounds of every caster when we last looked, to spot what moved. an entry that
+        // wasn't seen in a pass (removed, despawned, stopped casting) counts as moved away and gets erased
+        struct CasterState {
+            glm::mat4 matrix;
+            glm::vec3 min, max;
+            uint32_t seen; // casterPass it was last seen in
+        };
+        std::unordered_map<const Element*, CasterState> casterStates;
+        uint32_t casterPass = 0;
+        std::vector<glm::vec3> movedMin, movedMax; // world bounds (old and new) of casters that moved this frame
+        std::vector<std::pair<float, ElementDrawState*>> lightOrder;
+};
+
+#endif
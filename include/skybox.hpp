@@ -0,0 +1,26 @@
+#ifndef SKYBOX_HPP
+#define SKYBOX_HPP
+
+#include <vector>
+#include <string>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+
+// the sky is one fullscreen triangle sitting exactly on the far plane, drawn after the opaque geometry
+// so every pixel that's already covered gets thrown out by the depth test before the shader runs
+class Skybox {
+    public:
+        // faces in +x, -x, +y, -y, +z, -z order, see Texture::initCubemap
+        void init(const std::vector<std::string>& faceFiles);
+        // expects the depth buffer to already hold the opaque geometry
+        void draw(const glm::mat4& view, const glm::mat4& projection) const;
+        bool loaded() const { return cubemap.texture != 0; }
+        ~Skybox();
+    private:
+        Texture cubemap;
+        unsigned int VAO = 0; // empty, positions come from gl_VertexID
+};
+
+#endif
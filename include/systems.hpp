@@ -0,0 +1,45 @@
+#ifndef SYSTEMS_HPP
+#define SYSTEMS_HPP
+
+#include <functional>
+#include <vector>
+
+#include "ecs.hpp"
+#include "components.hpp"
+#include "element.hpp"
+
+// the game's world, every Element passed to addToWorld has an entity in here (Element::entity)
+extern World world;
+
+// Elements are still how scenes get built and what gameplay code pokes at, the world is what systems iterate.
+// pushElements copies every Element's current state into its components (and moves it to another archetype if
+// flags like anchored changed), pullElements copies what the systems changed back. main does push, physics
+// steps, pull once a frame, so anything written to an Element between frames shows up in the next step.
+ComponentMask elementMask(const Element& e);
+// the mask e would get if it were turned (orientation not identity) and/or spinning, whatever it is right now.
+// a Prefab reserves all of them since a SpawnTransform can do either
+ComponentMask elementMask(const Element& e, bool turned, bool spinning);
+void pushElement(World& world, Element& e);
+void pushElements(World& world);
+void pullElements(World& world);
+// physics runs in fixed steps that don't line up with frames, so things get drawn alpha (leftover time / step)
+// of the way from previousPosition to position, i.e. up to a step behind, instead of jumping a step at a time.
+// sets Element::renderOffset and renderOrientation, call it after pullElements
+void interpolateElements(World& world, float alpha);
+// nullptr once the entity is gone, so hold an Entity instead of an Element* for anything that can get removed
+Element* elementFor(const World& world, Entity entity);
+
+// one fixed step of the physics Element::physics_step used to do, over Transform+Bounds+Motion against
+// everything with a Collider, and Spin turning orientations. Bounds only find what might touch, if either side
+// has an OrientedBox the SAT test in collision.hpp decides and pushes out along its contact normal.
+// every Transform's previousPosition and previousOrientation become the current ones before the step.
+// shouldStop gets asked every 256 bodies (the physics bench's time budget), if it says yes the step is left
+// half done and this returns false
+bool physicsStep(World& world, float dt, const std::function<bool()>& shouldStop = nullptr);
+// how many AABB tests physicsStep has done in total, the physics bench diffs it per step
+extern unsigned long long physicsPairTests;
+// of the AABB overlaps, how many involved an OrientedBox and went through the SAT test, and how many of those
+// it found weren't touching at all
+extern unsigned long long physicsBoxTests, physicsBoxRejects;
+
+#endif
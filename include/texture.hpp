@@ -2,13 +2,20 @@
 #define TEXTURE_HPP
 
 #include <iostream>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 class Texture {
     public:
         unsigned int texture = 0; // make texture object
+        GLenum target = GL_TEXTURE_2D;
         void init(std::string textureFile);
+        // 6 files in +x, -x, +y, -y, +z, -z order, the same file can be used for several faces
+        // images that aren't square get the middle square cut out, and get scaled down to at most maxFaceSize
+        void initCubemap(const std::vector<std::string>& faceFiles, int maxFaceSize = 1024);
+        // straight from memory, no mipmaps, for small generated stuff like the HUD font
+        void initPixels(const unsigned char* pixels, int width, int height, GLenum format, GLenum filter);
         ~Texture();
 
         void use() const;
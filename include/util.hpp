@@ -1,5 +1,6 @@
 #ifndef UTIL_HPP
 #define UTIL_HPP
+#include <array>
 #include <glm/glm.hpp>
 #include "element.hpp"
 
@@ -7,16 +8,18 @@
 bool AABBCollideDetect(glm::vec3 bounding_box_corner1, glm::vec3 bounding_box_corner2, glm::vec3 bounding_box_corner3, glm::vec3 bounding_box_corner4);
 
 std::vector<float> calcBoundingBoxVerts(glm::vec3 c1, glm::vec3 c2, glm::vec3 color = glm::vec3(1.0f), bool debug = false);
-glm::uvec2 newDebugLine();
-void drawDebugLine(unsigned int VAO, unsigned int VBO, glm::vec3 origin, glm::vec3 direction, float length, Shader& debugShader, const glm::mat4& view, const glm::mat4& projection);
 
 // given 3 vertices, return normal vector
 inline glm::vec3 calcNormal(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2) {
     return glm::normalize(glm::cross((v1 - v0), (v2 - v0)));
 }
-// given list of vertices, return min and max
-std::vector<glm::vec3> calcBoundingBoxPoints(std::vector<float> vertices);
-std::vector<float> calcRotatedVerts(std::vector<float> vertices, glm::mat4 rotation, uint stride);
+// given list of vertices (positions every stride floats), return min and max
+std::array<glm::vec3, 2> calcBoundingBoxPoints(const float* vertices, size_t count, uint stride = 11);
+inline std::array<glm::vec3, 2> calcBoundingBoxPoints(const std::vector<float>& vertices) {
+    return calcBoundingBoxPoints(vertices.data(), vertices.size());
+}
+// box that fits around the min/max box after transforming it, without touching any vertices
+std::array<glm::vec3, 2> calcTransformedAABB(glm::vec3 min, glm::vec3 max, const glm::mat4& transform);
 
 struct Rayhit {
     Element* hitElement = nullptr;
@@ -26,6 +29,9 @@ struct Rayhit {
 
 Rayhit Raycast(glm::vec3 origin, glm::vec3 direction, std::vector<Element*>& Objects, Element* caster = nullptr);
 
+// resident memory of the process in bytes (from /proc/self/statm), 0 if we can't tell
+size_t currentRSS();
+
 struct KeyState {
     int currentState;
     int pastState;
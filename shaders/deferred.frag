@@ -0,0 +1,44 @@
+#version 460 core
+// lighting pass of the deferred path, runs once per pixel using the same clusters as the forward path
+out vec4 FragColor;
+in vec2 TexCoord;
+
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gDepth;
+uniform mat4 invViewProjection;
+uniform vec3 viewPos;
+
+#include "lighting.glsl"
+
+vec3 decodeNormal(vec2 f) {
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    float depth = texture(gDepth, TexCoord).r;
+    if (depth >= 1.0)
+        discard; // nothing was drawn here, keep the clear color
+
+    // rebuild world position from depth instead of storing it
+    vec4 clipPos = vec4(TexCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 worldPos = invViewProjection * clipPos;
+    vec3 fragPos = worldPos.xyz / worldPos.w;
+
+    vec3 norm = decodeNormal(texture(gNormal, TexCoord).rg);
+    vec3 albedo = texture(gAlbedo, TexCoord).rgb;
+
+    float ambientStrength = 0.01f;
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 lighting = ambientStrength * vec3(1.0f,1.0f,1.0f);
+    lighting += CalcSunLight(norm, viewDir, fragPos);
+    uvec2 cluster = clusters[getClusterIndex(depth)];
+    for (uint i = 0; i < cluster.y; i++) {
+        lighting += CalcPointLight(pointLights[lightIndices[cluster.x + i]], norm, viewDir, fragPos);
+    }
+    FragColor = vec4(lighting * albedo, 1.0f);
+}
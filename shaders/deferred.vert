@@ -0,0 +1,9 @@
+#version 460 core
+// fullscreen triangle, no vertex buffer needed
+out vec2 TexCoord;
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = pos;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
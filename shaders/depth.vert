@@ -0,0 +1,13 @@
+#version 460 core
+// depth pre-pass, position has to be computed exactly like object.vert or GL_EQUAL will reject fragments
+layout (location = 0) in vec3 aPos;
+invariant gl_Position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() { 
+    vec3 result = vec3(model * vec4(aPos, 1.0f));
+    gl_Position = projection * view * vec4(result, 1.0f);
+}
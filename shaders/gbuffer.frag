@@ -0,0 +1,32 @@
+#version 460 core
+// geometry pass of the deferred path, object.vert feeds this
+layout (location = 0) out vec2 gNormal; // octahedral packed, RG16_SNORM
+layout (location = 1) out vec4 gAlbedo;
+in vec3 color;
+in vec2 TexCoord;
+in vec3 FragPos;
+in vec3 Normal;
+uniform sampler2D Texture;
+uniform bool useTexture;
+
+vec2 octWrap(vec2 v) {
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+// squash a unit normal onto an octahedron and unfold it into a square, 2 values instead of 3
+vec2 encodeNormal(vec3 n) {
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void main() {
+    vec3 norm = normalize(Normal);
+    if (gl_FrontFacing) {
+        norm = -norm; // same flip as object.frag
+    }
+    gNormal = encodeNormal(norm);
+
+    vec3 albedo = color.rgb;
+    if (useTexture)
+        albedo *= texture(Texture, TexCoord).rgb;
+    gAlbedo = vec4(albedo, 1.0f);
+}
@@ -0,0 +1,96 @@
+// shared by object.frag and deferred.frag, pulled in with #include (see shader.cpp)
+// see lighting.hpp, lights are assigned to clusters on the cpu and we only loop over our cluster's list
+struct PointLight {
+    vec4 positionRange; // xyz position, w range
+    vec4 colorSpec; // rgb color, a specular strength
+    vec4 attenuation; // x constant, y linear, z quadratic, w shadow slot (-1 for none)
+};
+layout (std430, binding = 0) readonly buffer PointLightBuffer {
+    PointLight pointLights[];
+};
+layout (std430, binding = 1) readonly buffer ClusterBuffer {
+    uvec2 clusters[]; // offset into lightIndices, number of lights
+};
+layout (std430, binding = 2) readonly buffer LightIndexBuffer {
+    uint lightIndices[];
+};
+uniform float zNear;
+uniform float zFar;
+uniform vec2 screenSize;
+uniform ivec3 clusterDims;
+
+// shadows, see shadows.hpp
+uniform sampler2DArrayShadow cascadeShadowMap;
+uniform samplerCubeArrayShadow pointShadowMap;
+uniform mat4 cascadeMatrices[3];
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+uniform bool sunShadows;
+
+// fragDepth is window space depth (gl_FragCoord.z, or what the depth buffer holds)
+uint getClusterIndex(float fragDepth)
+{
+    float ndcZ = fragDepth * 2.0 - 1.0;
+    float depth = (2.0 * zNear * zFar) / (zFar + zNear - ndcZ * (zFar - zNear)); // back to view space depth
+    int slice = clamp(int(log(depth / zNear) * float(clusterDims.z) / log(zFar / zNear)), 0, clusterDims.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / screenSize * vec2(clusterDims.xy)), ivec2(0), clusterDims.xy - 1);
+    return uint(tile.x + clusterDims.x * (tile.y + clusterDims.y * slice));
+}
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 viewDir, vec3 fragPos)
+{
+    vec3 lightPos = light.positionRange.xyz;
+    vec3 lightColor = light.colorSpec.rgb;
+    float distance = length(lightPos - fragPos);
+    float attenuation = 1.0/(light.attenuation.x+light.attenuation.y*distance+light.attenuation.z*(distance*distance));
+    // fade out to exactly 0 at the light's range so the cluster cutoff doesn't leave a hard edge
+    float window = clamp(1.0 - pow(distance / light.positionRange.w, 4.0), 0.0, 1.0);
+    attenuation *= window * window;
+
+    int shadowSlot = int(light.attenuation.w);
+    if (shadowSlot >= 0) {
+        // cube map holds distance / range, compare against ours with a bit of slack for acne
+        vec3 fromLight = fragPos - lightPos;
+        attenuation *= texture(pointShadowMap, vec4(fromLight, float(shadowSlot)), distance / light.positionRange.w - 0.01);
+    }
+
+    vec3 lightDir = normalize(lightPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor; // diffuse lighting
+    // specular shading
+    float spec = pow(max(dot(viewDir,reflectDir),0.0f),32); // specular lighting
+    vec3 specular = light.colorSpec.a*spec*lightColor;
+
+    diffuse *= attenuation;
+    specular *= attenuation;
+    // ambient *= attenuation;
+
+    return (diffuse + specular);
+}
+
+// 1 lit, 0 in shadow. uses the first (sharpest) cascade that has this fragment in it
+float CalcSunShadow(vec3 normal, vec3 fragPos)
+{
+    for (int i = 0; i < 3; i++) {
+        // push the lookup out along the normal a bit, further for the bigger cascades
+        vec3 offsetPos = fragPos + normal * 0.02 * float(i + 1);
+        vec3 uvw = (cascadeMatrices[i] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+        if (all(greaterThan(uvw, vec3(0.0))) && all(lessThan(uvw, vec3(1.0))))
+            return texture(cascadeShadowMap, vec4(uvw.xy, float(i), uvw.z - 0.0005));
+    }
+    return 1.0; // past the last cascade
+}
+
+vec3 CalcSunLight(vec3 normal, vec3 viewDir, vec3 fragPos)
+{
+    vec3 lightDir = -sunDirection;
+    float diff = max(dot(normal, lightDir), 0.0);
+    if (diff <= 0.0 || sunColor == vec3(0.0))
+        return vec3(0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    float shadow = sunShadows ? CalcSunShadow(normal, fragPos) : 1.0;
+    return shadow * (diff + 0.5 * spec) * sunColor;
+}
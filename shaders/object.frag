@@ -9,38 +9,7 @@ uniform bool useTexture;
 
 uniform vec3 viewPos;
 
-struct PointLight {    
-    vec3 position;
-    vec3 color;
-    float specularStrength;
-
-    float constant;
-    float linear;
-    float quadratic;
-};
-uniform PointLight pointLights[16];
-uniform int numPointLights;
-
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 viewDir)
-{
-    float distance = length(light.position - FragPos);
-    float attenuation = 1.0/(light.constant+light.linear*distance+light.quadratic*(distance*distance));
-
-    vec3 lightDir = normalize(light.position - FragPos);
-    vec3 reflectDir = reflect(-lightDir, normal);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = diff * light.color; // diffuse lighting
-    // specular shading
-    float spec = pow(max(dot(viewDir,reflectDir),0.0f),32); // specular lighting
-    vec3 specular = light.specularStrength*spec*light.color;
-
-    diffuse *= attenuation;
-    specular *= attenuation;
-    // ambient *= attenuation;
-
-    return (diffuse + specular);
-} 
+#include "lighting.glsl"
 
 void main() {
     float ambientStrength = 0.01f;
@@ -53,8 +22,10 @@ void main() {
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 ambient = ambientStrength * vec3(1.0f,1.0f,1.0f);
     vec3 lighting = ambient; 
-    for (int i=0;i < numPointLights; i++) {
-        lighting += CalcPointLight(pointLights[i], norm, viewDir);
+    lighting += CalcSunLight(norm, viewDir, FragPos);
+    uvec2 cluster = clusters[getClusterIndex(gl_FragCoord.z)];
+    for (uint i = 0; i < cluster.y; i++) {
+        lighting += CalcPointLight(pointLights[lightIndices[cluster.x + i]], norm, viewDir, FragPos);
     }
 
     vec4 result = vec4(lighting*color.rgb, 1.0f);
@@ -8,6 +8,7 @@ out vec3 color;
 out vec2 TexCoord;
 out vec3 FragPos;
 out vec3 Normal;
+invariant gl_Position; // must match depth.vert for the pre-pass
 
 uniform mat4 model;
 uniform mat4 view;
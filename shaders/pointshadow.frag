@@ -0,0 +1,11 @@
+#version 460 core
+// stores distance to the light (scaled to 0..1 by its range) instead of perspective depth,
+// so the lookup in lighting.glsl is just length(fragPos - lightPos) / range
+in vec3 FragPos;
+
+uniform vec3 lightPos;
+uniform float range;
+
+void main() {
+    gl_FragDepth = length(FragPos - lightPos) / range;
+}
@@ -0,0 +1,13 @@
+#version 460 core
+// one face of a point light's cube shadow map
+layout (location = 0) in vec3 aPos;
+out vec3 FragPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() { 
+    FragPos = vec3(model * vec4(aPos, 1.0f));
+    gl_Position = projection * view * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,9 @@
+#version 460 core
+out vec4 FragColor;
+in vec3 Direction;
+
+uniform samplerCube skybox;
+
+void main() {
+    FragColor = vec4(texture(skybox, Direction).rgb, 1.0f);
+}
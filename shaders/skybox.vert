@@ -0,0 +1,12 @@
+#version 460 core
+// fullscreen triangle on the far plane, see skybox.hpp
+out vec3 Direction;
+
+uniform mat4 invViewProjection; // view without translation
+
+void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    vec4 world = invViewProjection * vec4(pos, 1.0, 1.0);
+    Direction = world.xyz / world.w;
+    gl_Position = vec4(pos, 1.0, 1.0); // z = w, so depth ends up exactly 1.0
+}
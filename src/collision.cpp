@@ -0,0 +1,140 @@
+#include <iostream>
+#include <float.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "collision.hpp"
+
+#define AXIS_EPSILON 1e-3f // cross products of (nearly) parallel edges, no direction worth testing, the face axes cover it
+#define EDGE_BIAS 1.05f // an edge axis has to beat the best face axis by this much, face contacts are steadier
+
+OrientedBox axisAlignedBox(const Bounds& bounds) {
+    OrientedBox box;
+    box.center = (bounds.min + bounds.max) * 0.5f;
+    box.axes[0] = glm::vec3(1.0f, 0.0f, 0.0f);
+    box.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = glm::vec3(0.0f, 0.0f, 1.0f);
+    box.halfExtents = (bounds.max - bounds.min) * 0.5f;
+    return box;
+}
+
+OrientedBox orientedBox(const glm::mat3& parentBasis, const glm::quat& orientation, glm::vec3 localMin, glm::vec3 localMax) {
+    OrientedBox box;
+    box.localCenter = (localMin + localMax) * 0.5f;
+    box.localHalfExtents = (localMax - localMin) * 0.5f;
+    box.parentBasis = parentBasis;
+    turnBox(box, orientation);
+    return box;
+}
+
+void turnBox(OrientedBox& box, const glm::quat& orientation) {
+    // the parent's basis can scale, so the columns aren't necessarily unit length
+    glm::mat3 m = box.parentBasis * glm::mat3_cast(orientation);
+    box.center = m * box.localCenter;
+    for (int i = 0; i < 3; i++) {
+        float length = glm::length(m[i]);
+        box.axes[i] = length > 0.0f ? m[i] / length : glm::vec3(i == 0, i == 1, i == 2);
+        box.halfExtents[i] = box.localHalfExtents[i] * length;
+    }
+}
+
+// the 15 candidate axes, structure of arrays so 4 of them go through at once. 16 so the last batch is full
+struct SatAxes {
+    alignas(16) float x[16], y[16], z[16];
+    alignas(16) float overlap[16];
+};
+
+static void buildAxes(const OrientedBox& a, const OrientedBox& b, SatAxes& axes) {
+    int n = 0;
+    auto add = [&](glm::vec3 axis) {
+        axes.x[n] = axis.x;
+        axes.y[n] = axis.y;
+        axes.z[n] = axis.z;
+        n++;
+    };
+    for (int i = 0; i < 3; i++) add(a.axes[i]);
+    for (int i = 0; i < 3; i++) add(b.axes[i]);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++) add(glm::cross(a.axes[i], b.axes[j]));
+    add(glm::vec3(0.0f)); // padding, comes out as "no axis"
+}
+
+// overlap[k] = how far the boxes overlap along axis k (normalized), FLT_MAX for a degenerate axis
+#if defined(__SSE2__)
+static inline __m128 dot4(__m128 x, __m128 y, __m128 z, glm::vec3 v) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(v.x)), _mm_mul_ps(y, _mm_set1_ps(v.y))), _mm_mul_ps(z, _mm_set1_ps(v.z)));
+}
+
+static void project(const OrientedBox& a, const OrientedBox& b, glm::vec3 t, SatAxes& axes) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 epsilon = _mm_set1_ps(AXIS_EPSILON);
+    const __m128 none = _mm_set1_ps(FLT_MAX);
+    for (int k = 0; k < 16; k += 4) {
+        __m128 x = _mm_load_ps(axes.x + k), y = _mm_load_ps(axes.y + k), z = _mm_load_ps(axes.z + k);
+        __m128 ra = _mm_setzero_ps(), rb = _mm_setzero_ps();
+        for (int i = 0; i < 3; i++) {
+            ra = _mm_add_ps(ra, _mm_mul_ps(_mm_set1_ps(a.halfExtents[i]), _mm_and_ps(dot4(x, y, z, a.axes[i]), absMask)));
+            rb = _mm_add_ps(rb, _mm_mul_ps(_mm_set1_ps(b.halfExtents[i]), _mm_and_ps(dot4(x, y, z, b.axes[i]), absMask)));
+        }
+        __m128 distance = _mm_and_ps(dot4(x, y, z, t), absMask);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 degenerate = _mm_cmplt_ps(length, epsilon);
+        // degenerate lanes divide by 0 here, the select below throws that away
+        __m128 overlap = _mm_div_ps(_mm_sub_ps(_mm_add_ps(ra, rb), distance), _mm_max_ps(length, epsilon));
+        overlap = _mm_or_ps(_mm_and_ps(degenerate, none), _mm_andnot_ps(degenerate, overlap));
+        _mm_store_ps(axes.overlap + k, overlap);
+    }
+}
+#else
+static void project(const OrientedBox& a, const OrientedBox& b, glm::vec3 t, SatAxes& axes) {
+    for (int k = 0; k < 16; k++) {
+        glm::vec3 axis(axes.x[k], axes.y[k], axes.z[k]);
+        float length = glm::length(axis);
+        if (length < AXIS_EPSILON) {
+            axes.overlap[k] = FLT_MAX;
+            continue;
+        }
+        float ra = 0.0f, rb = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            ra += a.halfExtents[i] * fabsf(glm::dot(axis, a.axes[i]));
+            rb += b.halfExtents[i] * fabsf(glm::dot(axis, b.axes[i]));
+        }
+        axes.overlap[k] = (ra + rb - fabsf(glm::dot(axis, t))) / length;
+    }
+}
+#endif
+
+bool collideBoxes(glm::vec3 positionA, const OrientedBox& a, glm::vec3 positionB, const OrientedBox& b, Contact& contact) {
+    glm::vec3 t = (positionA + a.center) - (positionB + b.center);
+    SatAxes axes;
+    buildAxes(a, b, axes);
+    project(a, b, t, axes);
+    int best = -1;
+    float bestScore = FLT_MAX;
+    for (int k = 0; k < 15; k++) {
+        float overlap = axes.overlap[k];
+        if (overlap < 0.0f) return false; // found a gap
+        if (overlap == FLT_MAX) continue;
+        float score = k < 6 ? overlap : overlap * EDGE_BIAS;
+        if (score < bestScore) {
+            bestScore = score;
+            best = k;
+        }
+    }
+    if (best < 0) return false;
+    glm::vec3 normal = glm::normalize(glm::vec3(axes.x[best], axes.y[best], axes.z[best]));
+    if (glm::dot(normal, t) < 0.0f) normal = -normal; // point from b to a
+    contact.normal = normal;
+    contact.depth = axes.overlap[best];
+    // a's corner that's deepest into b, pulled halfway back out
+    glm::vec3 point = positionA + a.center;
+    for (int i = 0; i < 3; i++)
+        point -= a.axes[i] * (a.halfExtents[i] * (glm::dot(a.axes[i], normal) > 0.0f ? 1.0f : -1.0f));
+    contact.point = point + normal * (contact.depth * 0.5f);
+    return true;
+}
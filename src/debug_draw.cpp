@@ -0,0 +1,187 @@
+#include <iostream>
+#include <cstddef>
+#include <math.h>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "debug_draw.hpp"
+#include "element.hpp"
+#include "shader_def.hpp"
+#include "memory_tracking.hpp"
+
+DebugDraw debugDraw;
+
+static uint32_t packColor(glm::vec3 color) {
+    glm::uvec3 c = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return c.r | (c.g << 8) | (c.b << 16) | (255u << 24);
+}
+
+void DebugDraw::init() {
+    if (mapped) return;
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // immutable storage so it can stay mapped forever, coherent so we don't have to flush ranges either
+    GLsizeiptr bytes = sizeof(DebugVertex) * DEBUG_DRAW_MAX_VERTICES * DEBUG_DRAW_FRAMES;
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+    mapped = (DebugVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags);
+    if (!mapped)
+        std::cout << "debug_draw.cpp: couldn't map the debug line buffer, debug drawing is off\n";
+    trackGpuObject(GpuObjectKind::Buffer, VBO, bytes, MemoryTag::Debug);
+
+    // same inputs as the old debug Elements, so debug.vert doesn't change
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex), (void*)offsetof(DebugVertex, color));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    section = 0;
+    vertexCount = 0;
+}
+
+void DebugDraw::release() {
+    for (GLsync& fence : fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (VBO) {
+        untrackGpuObject(GpuObjectKind::Buffer, VBO);
+        if (mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glDeleteBuffers(1, &VBO);
+    }
+    if (VAO) glDeleteVertexArrays(1, &VAO);
+    VAO = VBO = 0;
+    mapped = nullptr;
+    vertexCount = 0;
+}
+
+DebugDraw::~DebugDraw() {
+    // can't call GL here, the context is usually gone by the time statics get destroyed. the renderer releases us
+}
+
+DebugVertex* DebugDraw::reserve(size_t count) {
+    if (!mapped || !renderDebug) return nullptr;
+    if (vertexCount + count > DEBUG_DRAW_MAX_VERTICES) {
+        if (droppedVertices == 0)
+            printf("debug_draw.cpp: more than %i debug vertices this frame, dropping the rest\n", DEBUG_DRAW_MAX_VERTICES);
+        droppedVertices += count;
+        return nullptr;
+    }
+    DebugVertex* vertices = mapped + (size_t)section * DEBUG_DRAW_MAX_VERTICES + vertexCount;
+    vertexCount += count;
+    return vertices;
+}
+
+void DebugDraw::line(glm::vec3 from, glm::vec3 to, glm::vec3 color) {
+    DebugVertex* v = reserve(2);
+    if (!v) return;
+    uint32_t c = packColor(color);
+    v[0] = {from, c};
+    v[1] = {to, c};
+}
+
+void DebugDraw::ray(glm::vec3 origin, glm::vec3 direction, float length) {
+    direction = glm::normalize(direction);
+    ray(origin, direction, length, glm::abs(direction));
+}
+
+void DebugDraw::ray(glm::vec3 origin, glm::vec3 direction, float length, glm::vec3 color) {
+    line(origin, origin + glm::normalize(direction) * length, color);
+}
+
+void DebugDraw::arrow(glm::vec3 from, glm::vec3 to, glm::vec3 color, float headSize) {
+    DebugVertex* v = reserve(10);
+    if (!v) return;
+    uint32_t c = packColor(color);
+    glm::vec3 direction = to - from;
+    float length = glm::length(direction);
+    direction = length > 0.0f ? direction / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    // any two directions perpendicular to the arrow for the 4 head lines
+    glm::vec3 other = glm::abs(direction.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 side = glm::normalize(glm::cross(direction, other)) * headSize;
+    glm::vec3 up = glm::cross(side, direction);
+    glm::vec3 headBase = to - direction * headSize * 2.0f;
+    v[0] = {from, c};
+    v[1] = {to, c};
+    v[2] = {to, c}; v[3] = {headBase + side, c};
+    v[4] = {to, c}; v[5] = {headBase - side, c};
+    v[6] = {to, c}; v[7] = {headBase + up, c};
+    v[8] = {to, c}; v[9] = {headBase - up, c};
+}
+
+void DebugDraw::box(glm::vec3 min, glm::vec3 max, glm::vec3 color) {
+    DebugVertex* v = reserve(24);
+    if (!v) return;
+    uint32_t c = packColor(color);
+    glm::vec3 corners[8] = {
+        {min.x, min.y, min.z}, {max.x, min.y, min.z}, {max.x, max.y, min.z}, {min.x, max.y, min.z},
+        {min.x, min.y, max.z}, {max.x, min.y, max.z}, {max.x, max.y, max.z}, {min.x, max.y, max.z}
+    };
+    // same 12 edges as CUBEBB_INDICES
+    static const int edges[24] = {0,1, 1,2, 2,3, 3,0, 4,5, 5,6, 6,7, 7,4, 0,4, 1,5, 2,6, 3,7};
+    for (int i = 0; i < 24; i++)
+        v[i] = {corners[edges[i]], c};
+}
+
+void DebugDraw::sphere(glm::vec3 center, float radius, glm::vec3 color, int segments) {
+    if (segments < 3) segments = 3;
+    DebugVertex* v = reserve(segments * 6);
+    if (!v) return;
+    uint32_t c = packColor(color);
+    float step = glm::two_pi<float>() / segments;
+    for (int i = 0; i < segments; i++) {
+        float s0 = sinf(i * step) * radius, c0 = cosf(i * step) * radius;
+        float s1 = sinf((i + 1) * step) * radius, c1 = cosf((i + 1) * step) * radius;
+        *v++ = {center + glm::vec3(c0, s0, 0.0f), c}; *v++ = {center + glm::vec3(c1, s1, 0.0f), c}; // around z
+        *v++ = {center + glm::vec3(c0, 0.0f, s0), c}; *v++ = {center + glm::vec3(c1, 0.0f, s1), c}; // around y
+        *v++ = {center + glm::vec3(0.0f, c0, s0), c}; *v++ = {center + glm::vec3(0.0f, c1, s1), c}; // around x
+    }
+}
+
+void DebugDraw::point(glm::vec3 position, float size, glm::vec3 color) {
+    DebugVertex* v = reserve(6);
+    if (!v) return;
+    uint32_t c = packColor(color);
+    float h = size * 0.5f;
+    v[0] = {position - glm::vec3(h, 0.0f, 0.0f), c}; v[1] = {position + glm::vec3(h, 0.0f, 0.0f), c};
+    v[2] = {position - glm::vec3(0.0f, h, 0.0f), c}; v[3] = {position + glm::vec3(0.0f, h, 0.0f), c};
+    v[4] = {position - glm::vec3(0.0f, 0.0f, h), c}; v[5] = {position + glm::vec3(0.0f, 0.0f, h), c};
+}
+
+void DebugDraw::waitForSection(int which) {
+    GLsync& fence = fences[which];
+    if (!fence) return;
+    // normally already signaled, the gpu would have to be DEBUG_DRAW_FRAMES frames behind for this to block
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+int DebugDraw::flush(const glm::mat4& view, const glm::mat4& projection) {
+    if (!mapped) return 0;
+    lastVertexCount = vertexCount;
+    int draws = 0;
+    if (vertexCount > 0) {
+        debugShader->use();
+        debugShader->setMat4("model", glm::mat4(1.0f));
+        debugShader->setMat4("view", view);
+        debugShader->setMat4("projection", projection);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_LINES, section * DEBUG_DRAW_MAX_VERTICES, vertexCount);
+        glBindVertexArray(0);
+        fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        draws = 1;
+    }
+    // next frame writes into the next section, once the gpu is done with whatever it last drew from there
+    section = (section + 1) % DEBUG_DRAW_FRAMES;
+    waitForSection(section);
+    vertexCount = 0;
+    return draws;
+}
@@ -0,0 +1,214 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+
+#include "ecs.hpp"
+
+size_t componentSizes[ECS_MAX_COMPONENTS] = {};
+static int componentCount = 0;
+
+int registerComponent(size_t size) {
+    if (componentCount == ECS_MAX_COMPONENTS) {
+        printf("ecs.cpp: more than %i component types, bump ECS_MAX_COMPONENTS\n", ECS_MAX_COMPONENTS);
+        abort();
+    }
+    componentSizes[componentCount] = size;
+    return componentCount++;
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+Archetype::Archetype(ComponentMask aMask) : mask(aMask) {
+    // entity ids first, then one array per component. every array starts 16 byte aligned so vec3/vec4 loads are happy
+    size_t rowBytes = sizeof(Entity);
+    int columns = 0;
+    for (int i = 0; i < ECS_MAX_COMPONENTS; i++) {
+        if (!(mask & (ComponentMask(1) << i))) continue;
+        rowBytes += componentSizes[i];
+        columns++;
+    }
+    chunkCapacity = (ECS_CHUNK_BYTES - 16 * (columns + 1)) / rowBytes;
+    if (chunkCapacity == 0) chunkCapacity = 1;
+
+    size_t offset = alignUp(sizeof(Entity) * chunkCapacity, 16);
+    for (int i = 0; i < ECS_MAX_COMPONENTS; i++) {
+        offsets[i] = 0;
+        if (!(mask & (ComponentMask(1) << i))) continue;
+        offsets[i] = offset;
+        offset = alignUp(offset + componentSizes[i] * chunkCapacity, 16);
+    }
+}
+
+Archetype::~Archetype() {
+    for (Chunk& chunk : chunks)
+        operator delete(chunk.data, std::align_val_t(64));
+    for (unsigned char* data : spareChunks)
+        operator delete(data, std::align_val_t(64));
+}
+
+size_t Archetype::reservedChunks() const {
+    if (reservedEntities == 0) return 0;
+    // +1 for the partly full chunk whatever else lives in this archetype left
+    return (reservedEntities + chunkCapacity - 1) / chunkCapacity + 1;
+}
+
+void Archetype::reserve(size_t count) {
+    reservedEntities += count;
+    while (chunks.size() + spareChunks.size() < reservedChunks())
+        spareChunks.push_back((unsigned char*)operator new(ECS_CHUNK_BYTES, std::align_val_t(64)));
+    chunks.reserve(reservedChunks()); // the list of chunks shouldn't grow either when a spare one goes into use
+}
+
+void* Archetype::column(size_t chunk, int component) const {
+    if (!(mask & (ComponentMask(1) << component))) return nullptr;
+    return chunks[chunk].data + offsets[component];
+}
+
+void Archetype::push(Entity entity, uint32_t& chunk, uint32_t& row) {
+    if (chunks.empty() || chunks.back().count == chunkCapacity) {
+        Chunk fresh;
+        if (!spareChunks.empty()) {
+            fresh.data = spareChunks.back();
+            spareChunks.pop_back();
+        } else
+            fresh.data = (unsigned char*)operator new(ECS_CHUNK_BYTES, std::align_val_t(64));
+        chunks.push_back(fresh);
+    }
+    chunk = chunks.size() - 1;
+    Chunk& last = chunks.back();
+    row = last.count++;
+    entities(chunk)[row] = entity;
+    for (int i = 0; i < ECS_MAX_COMPONENTS; i++) {
+        if (!(mask & (ComponentMask(1) << i))) continue;
+        memset(last.data + offsets[i] + componentSizes[i] * row, 0, componentSizes[i]);
+    }
+    entityCount++;
+}
+
+Entity Archetype::removeSwap(uint32_t chunk, uint32_t row) {
+    uint32_t lastChunk = chunks.size() - 1;
+    uint32_t lastRow = chunks[lastChunk].count - 1;
+    Entity moved = NO_ENTITY;
+    if (chunk != lastChunk || row != lastRow) {
+        moved = entities(lastChunk)[lastRow];
+        entities(chunk)[row] = moved;
+        for (int i = 0; i < ECS_MAX_COMPONENTS; i++) {
+            if (!(mask & (ComponentMask(1) << i))) continue;
+            size_t size = componentSizes[i];
+            memcpy(chunks[chunk].data + offsets[i] + size * row, chunks[lastChunk].data + offsets[i] + size * lastRow, size);
+        }
+    }
+    if (--chunks[lastChunk].count == 0) {
+        if (chunks.size() - 1 + spareChunks.size() < reservedChunks())
+            spareChunks.push_back(chunks[lastChunk].data);
+        else
+            operator delete(chunks[lastChunk].data, std::align_val_t(64));
+        chunks.pop_back();
+    }
+    entityCount--;
+    return moved;
+}
+
+World::~World() {
+    clear();
+}
+
+Archetype* World::archetypeFor(ComponentMask mask) {
+    for (Archetype* archetype : archetypes)
+        if (archetype->mask == mask) return archetype;
+    archetypes.push_back(new Archetype(mask));
+    return archetypes.back();
+}
+
+Entity World::create(ComponentMask mask) {
+    Entity entity;
+    if (!freeSlots.empty()) {
+        entity.index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        entity.index = records.size();
+        records.push_back(Record());
+        records.back().generation = firstGeneration;
+    }
+    Record& record = records[entity.index];
+    entity.generation = record.generation;
+    record.archetype = archetypeFor(mask);
+    record.archetype->push(entity, record.chunk, record.row);
+    liveCount++;
+    return entity;
+}
+
+void World::destroy(Entity entity) {
+    if (!alive(entity)) return;
+    Record& record = records[entity.index];
+    Entity moved = record.archetype->removeSwap(record.chunk, record.row);
+    if (moved != NO_ENTITY) {
+        records[moved.index].chunk = record.chunk;
+        records[moved.index].row = record.row;
+    }
+    record.archetype = nullptr;
+    record.generation++; // every handle to the old entity is dead now
+    freeSlots.push_back(entity.index);
+    liveCount--;
+    if (liveCount == 0 && !hasReserves()) clear(); // give everything back, e.g. between benchmark runs
+}
+
+bool World::hasReserves() const {
+    for (const Archetype* archetype : archetypes)
+        if (archetype->reservedEntities > 0) return true;
+    return false;
+}
+
+void World::clear() {
+    for (const Record& record : records)
+        firstGeneration = std::max(firstGeneration, record.generation + 1);
+    for (Archetype* archetype : archetypes)
+        delete archetype;
+    std::vector<Archetype*>().swap(archetypes);
+    std::vector<Record>().swap(records);
+    std::vector<uint32_t>().swap(freeSlots);
+    liveCount = 0;
+}
+
+void World::reserve(ComponentMask mask, size_t count) {
+    archetypeFor(mask)->reserve(count);
+    records.reserve(records.size() + count);
+    freeSlots.reserve(records.capacity());
+}
+
+bool World::alive(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].archetype != nullptr && records[entity.index].generation == entity.generation;
+}
+
+ComponentMask World::mask(Entity entity) const {
+    return alive(entity) ? records[entity.index].archetype->mask : 0;
+}
+
+void World::setMask(Entity entity, ComponentMask newMask) {
+    if (!alive(entity)) return;
+    Record& record = records[entity.index];
+    Archetype* from = record.archetype;
+    if (from->mask == newMask) return;
+    Archetype* to = archetypeFor(newMask);
+
+    uint32_t chunk, row;
+    to->push(entity, chunk, row);
+    ComponentMask shared = from->mask & newMask;
+    for (int i = 0; i < ECS_MAX_COMPONENTS; i++) {
+        if (!(shared & (ComponentMask(1) << i))) continue;
+        size_t size = componentSizes[i];
+        memcpy(to->chunks[chunk].data + to->offsets[i] + size * row, from->chunks[record.chunk].data + from->offsets[i] + size * record.row, size);
+    }
+    Entity moved = from->removeSwap(record.chunk, record.row);
+    if (moved != NO_ENTITY) {
+        records[moved.index].chunk = record.chunk;
+        records[moved.index].row = record.row;
+    }
+    record.archetype = to;
+    record.chunk = chunk;
+    record.row = row;
+}
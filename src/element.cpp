@@ -1,9 +1,11 @@
 #include <iostream>
+#include <cassert>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include <math.h>
 #include <random>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -15,10 +17,15 @@
 #include "util.hpp"
 #include "element.hpp"
 #include "shader_def.hpp"
+#include "profiler.hpp"
+#include "memory_tracking.hpp"
+#include "systems.hpp"
 
 std::vector<Element*> PointLights;
-bool renderDebug = true;
+std::atomic<bool> renderDebug{true};
 void Element::init() {
+    MemoryTag memoryTag = debug ? MemoryTag::Debug : MemoryTag::Meshes;
+    MEMORY_TAG(memoryTag);
     if (useTexture)
         texture.init(textureFile);
     glGenVertexArrays(1, &VAO);
@@ -27,11 +34,13 @@ void Element::init() {
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, VBO, vertices.size() * sizeof(float), memoryTag);
 
     glGenBuffers(1, &EBO);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, EBO, indices.size() * sizeof(unsigned int), memoryTag);
     if (!debug) {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
@@ -44,6 +53,22 @@ void Element::init() {
 
         glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(8*sizeof(float)));
         glEnableVertexAttribArray(3);
+
+        // tightly packed positions for the depth pre-pass, so it doesn't drag colors/uvs/normals through the cache
+        std::vector<float> positions;
+        positions.reserve(vertices.size() / 11 * 3);
+        for (size_t i = 0; i < vertices.size(); i=i+11) {
+            positions.insert(positions.end(), {vertices[i+0], vertices[i+1], vertices[i+2]});
+        }
+        glGenVertexArrays(1, &depthVAO);
+        glBindVertexArray(depthVAO);
+        glGenBuffers(1, &positionVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+        trackGpuObject(GpuObjectKind::Buffer, positionVBO, positions.size() * sizeof(float), memoryTag);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
     } else {
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
@@ -55,77 +80,74 @@ void Element::init() {
     if (emitPointLight) {
         PointLights.push_back(this);
     }
-    // debugVAOVBO = newDebugLine();
+
+    indexCount = indices.size();
+    if (!debug) { // debug elements don't collide
+        std::array<glm::vec3, 2> localBounds = calcBoundingBoxPoints(vertices);
+        localBoundsMin = localBounds[0];
+        localBoundsMax = localBounds[1];
+        if (vertices.empty()) { // no mesh (the player), whatever box we were given is all there is
+            localBoundsMin = bounding_box_corner1;
+            localBoundsMax = bounding_box_corner2;
+        }
+    }
+    if (!keepCpuMesh) {
+        // the gpu has its own copy now, swap with empty ones so the memory actually goes away
+        std::vector<float>().swap(vertices);
+        std::vector<unsigned int>().swap(indices);
+    }
 };
-void Element::draw(const glm::mat4& view, const glm::mat4& projection, Element& lightSource, glm::vec3 cameraPos, float time) const {
-    if (!renderDebug && debug) return;
-    if (!shader) return;
+void Element::update(float deltaTime) { // deltaTime is how long since last frame and current (i think)
+    // spinning is physics' job now (angularVelocity), this only refits the box to however we ended up turned.
+    // physics refits its own copy after every step, this keeps ours in line for setRotation/rotateBy
+    if (orientation != boundsOrientation) fitBounds();
+}
 
+glm::mat4 Element::getBoundsMatrix() const {
+    glm::mat3 rotation = sceneBasis * glm::mat3_cast(orientation);
+    return glm::mat4(glm::vec4(rotation[0] * sizex, 0.0f), glm::vec4(rotation[1] * sizey, 0.0f), glm::vec4(rotation[2] * sizez, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
 
-    shader->use();
-    shader->setMat4("view", view);
-    shader->setMat4("projection", projection);
-    shader->setMat4("model", getMatrix());
-    shader->setInt("useTexture", getUseTexture());
-    // shader->setVec3("lightColor", lightSource.lightColor);
-    // shader->setVec3("lightPos", glm::vec3(lightSource.position.x, lightSource.position.y, lightSource.position.z));
-    shader->setVec3("viewPos", cameraPos);
-    if (wireframe || debug)
-        glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-    if (useTexture)
-        texture.use();
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glDrawElements(draw_mode, indices.size(), GL_UNSIGNED_INT, 0);
-    if (wireframe || debug)
-        glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-    if (useTexture)
-        texture.unUse();
-    // draw debug ray
-    // drawDebugLine(debugVAOVBO.x, debugVAOVBO.y, position, glm::vec3(0.0f, -1.0f, 0.0f), 1.0f, *debugShader, view, projection);
+void Element::fitBounds() {
+    boundsOrientation = orientation;
+    if (localBoundsMin == localBoundsMax) return;
+    std::array<glm::vec3, 2> rotatedAABB = calcTransformedAABB(localBoundsMin, localBoundsMax, getBoundsMatrix());
+    bounding_box_corner1 = rotatedAABB[0];
+    bounding_box_corner2 = rotatedAABB[1];
+}
 
-};
-void Element::update(float deltaTime) { // deltaTime is how long since last frame and current (i think)
-    if (debugElement != nullptr)
-        debugElement->position = position;
-    if (rotate) { // this is for the matrix we use to render it, we should also implement obb and rotate that aswell.
-        currentAngle += rotationSpeed * deltaTime;
-        if (currentAngle > glm::two_pi<float>()) currentAngle -= glm::two_pi<float>();
-    }
-    if ((glm::abs(rotation.x - pastRotation.x) > 0.001f) || ((glm::abs(rotation.y - pastRotation.y) > 0.001f)) || (glm::abs(rotation.z - pastRotation.z) > 0.001f)) {
-        glm::mat4 rotateMatrix(1.0f);
-        rotateMatrix = glm::rotate(rotateMatrix, rotation.x, glm::vec3(1,0,0));
-        rotateMatrix = glm::rotate(rotateMatrix, rotation.y, glm::vec3(0,1,0));
-        rotateMatrix = glm::rotate(rotateMatrix, rotation.z, glm::vec3(0,0,1));
-        std::vector<float> rotatedVerts = calcRotatedVerts(vertices, getMatrix(false), 11);
-        std::vector<glm::vec3> rotatedAABB = calcBoundingBoxPoints(rotatedVerts);
-        bounding_box_corner1 = rotatedAABB[0];
-        bounding_box_corner2 = rotatedAABB[1];
-
-        if (debugElement != nullptr) {
-            debugElement->vertices = calcBoundingBoxVerts(bounding_box_corner1, bounding_box_corner2, glm::vec3(1.0f,0.0f,0.0f),true);
-            debugElement->init();
-        }
-    }
+void Element::setRotation(glm::vec3 euler) {
+    // same order the old glm::rotate x, y, z chain had
+    orientation = glm::angleAxis(euler.x, glm::vec3(1, 0, 0)) * glm::angleAxis(euler.y, glm::vec3(0, 1, 0)) * glm::angleAxis(euler.z, glm::vec3(0, 0, 1));
+    previousOrientation = renderOrientation = orientation;
+}
 
-    pastRotation = rotation;
+void Element::rotateBy(glm::vec3 euler) {
+    orientation = glm::normalize(glm::quat(euler) * orientation);
+    previousOrientation = renderOrientation = orientation;
 }
-        
+
 glm::mat4 Element::getMatrix(bool translate) const { // get model matrix
-    glm::mat4 model = glm::mat4(1.0f); // define 4x4 matrix
-    if (translate) {
-        model = glm::translate(model, position); // add position translation to matrix
-        model = glm::translate(model, pivot); // translate first by pivot point
+    // draw, the depth pre-pass and every shadow cascade/cube face all ask for this, and most things never rotate
+    glm::vec3 size(sizex, sizey, sizez);
+    if (renderOrientation != cachedOrientation || size != cachedSize || sceneBasis != cachedBasis)
+        matrixDirty = true;
+    if (matrixDirty) {
+        // no trig, a quaternion to matrix is a few multiplies. sceneBasis is identity unless a parent in the
+        // scene graph turns us
+        glm::mat3 rotation = sceneBasis * glm::mat3_cast(renderOrientation);
+        cachedRotationMatrix = glm::mat4(glm::vec4(rotation[0] * size.x, 0.0f), glm::vec4(rotation[1] * size.y, 0.0f), glm::vec4(rotation[2] * size.z, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        cachedOrientation = renderOrientation;
+        cachedSize = size;
+        cachedBasis = sceneBasis;
+        matrixDirty = false;
     }
+    if (!translate) return cachedRotationMatrix;
 
-    model = glm::rotate(model, rotation.x, glm::vec3(1, 0, 0)); // rotate on x,y,z
-    model = glm::rotate(model, rotation.y, glm::vec3(0, 1, 0));
-    model = glm::rotate(model, rotation.z, glm::vec3(0, 0, 1));
-    model = glm::rotate(model, currentAngle, rotateAxis); // if continuosly rotating, rotate by current angle on rotate axis
-    model = glm::scale(model, glm::vec3(sizex, sizey, sizez));
-    if (translate) {
-        model = glm::translate(model, -pivot); // translate by negative pivot point, no idea why we do this i think i stole this from somewhere
-    }
+    // translate(position + pivot) * rotation/scale * translate(-pivot), without the matrix multiplies.
+    // the pivot dance is rotating around the pivot instead of our origin
+    glm::mat4 model = cachedRotationMatrix;
+    model[3] = glm::vec4(renderPosition() + pivot - glm::vec3(cachedRotationMatrix * glm::vec4(pivot, 0.0f)), 1.0f);
     return model;
 }
 
@@ -133,108 +155,35 @@ bool Element::getUseTexture() const {
     return useTexture;
 }
 
-void Element::physics_step(float dt, std::vector<Element*>& Objects) {
-    if (anchored) return;
-    if (gravity && !anchored) {
-        velocity.y += -9.8f * dt;
-    }
-    if (holdVelocity != glm::vec3(0.0f)) {
-        velocity += holdVelocity;
-    }
-
-    // now dampen so it doesn't fly forever
-    float damping = 2.0f; // units per second
-    if (glm::length(velocity) > 0.0f) {
-        glm::vec3 decel = glm::normalize(velocity) * damping * dt;
-        if (glm::length(decel) > glm::length(velocity))
-            velocity = glm::vec3(0.0f); // stop completely
-        else {
-            velocity -= decel;
-        }
-    }
-    if (glm::length(velocity) < 0.1f) {
-        velocity = glm::vec3(0.0f);
+Element::~Element() {
+    // the GL deletes below need the context, which only the main thread has. that's also the render thread,
+    // so it can't be halfway through drawing our buffers from a snapshot while this runs
+    assert(onMainThread());
+    removeFromWorld(this);
+    if (sceneNode != NO_SCENE_NODE) sceneGraph.destroy(sceneNode);
+    if (emitPointLight) {
+        auto light = std::find(PointLights.begin(), PointLights.end(), this);
+        if (light != PointLights.end()) PointLights.erase(light); // keep the order, light slots in the shader follow it
     }
-    position += velocity * dt; // apply velocity
-    grounded = false; // we check if grounded later so we js reset until then
-    // me after figuring out previous line: https://tenor.com/view/aaaughhhh-gif-10795548499260202596
-
-    if (lastPosition != position && (hasCollision)) {
-        for (size_t i = 0; i < Objects.size(); i++) {
-
-            if (Objects[i] == this) {continue;}
-            if (Objects[i]->debug == true) {continue;} // do not collide with debug elements
-            if (Objects[i]->position == position) {continue;} // oh the horrors
-            if (!Objects[i]->hasCollision) continue;
-            if (Objects[i]->id == id) continue; 
-            
-            if (AABBCollideDetect(position+bounding_box_corner1,
-                position+bounding_box_corner2,
-                Objects[i]->position+Objects[i]->bounding_box_corner1, 
-                Objects[i]->position+Objects[i]->bounding_box_corner2)) {
-                // printf("Collision at %f, pos1: %f %f %f, pos2: %f %f %f\n", glfwGetTime(),Objects[i]->position.x, Objects[i]->position.y, Objects[i]->position.z, position.x, position.y, position.z);
-                float px = std::min(position.x+bounding_box_corner2.x, Objects[i]->position.x+Objects[i]->bounding_box_corner2.x) - std::max(position.x+bounding_box_corner1.x, Objects[i]->position.x+Objects[i]->bounding_box_corner1.x);
-                float py = std::min(position.y+bounding_box_corner2.y, Objects[i]->position.y+Objects[i]->bounding_box_corner2.y) - std::max(position.y+bounding_box_corner1.y, Objects[i]->position.y+Objects[i]->bounding_box_corner1.y);
-                float pz = std::min(position.z+bounding_box_corner2.z, Objects[i]->position.z+Objects[i]->bounding_box_corner2.z) - std::max(position.z+bounding_box_corner1.z, Objects[i]->position.z+Objects[i]->bounding_box_corner1.z);
-                // we're checking which axis has the most overlap, setting pos of 1 object to not be inside the other, setting vel on that axis to 0
-                // this should probably have it's own func, or be in physics_step
-                if (bounce) {
-                    if (px < py && px < pz) { // z axis has most overlap
-                        float dir = (position.x < Objects[i]->position.x) ? -1.0f : 1.0f;
-                        position.x += px * dir;
-                        velocity.x = -velocity.x * bounce_amount;
-                        if (glm::abs(velocity.x) < 0.08f) velocity.x = 0.0f;
-                    }
-                    else if (py < pz) { // y axis has most overlap
-                        if (grounded) return;
-                        // float dir = (position.y < Objects[i]->position.y) ? -1.0f : 1.0f;
-                        // position.y += py * dir;
-                        velocity.y = -velocity.y * bounce_amount;
-                        if (glm::abs(velocity.y) < 0.08f) velocity.y = 0.0f;
-                    }
-                    else { // x axis overlap
-                        float dir = (position.z < Objects[i]->position.z) ? -1.0f : 1.0f;
-                        position.z += pz * dir;
-                        velocity.z = -velocity.z;
-                        if (glm::abs(velocity.z) < 0.08f) velocity.z = 0.0f;
-                    }
-                } else {
-                    if (px < py && px < pz) {
-                        float dir = (position.x < Objects[i]->position.x) ? -1.0f : 1.0f;
-                        position.x += px * dir;
-                        Objects[i]->velocity.x = velocity.x;
-                        velocity.x = 0;
-                        // printf("x collide\n");
-                    } else if (py < pz) { // y collide
-                        float dir = (position.y < Objects[i]->position.y) ? -1.0f : 1.0f;
-                        position.y += py * dir;
-                        Objects[i]->velocity.y = velocity.y;
-                        if (dir == 1.0f) // if we are falling/pushing down 
-                            grounded = true;
-                        velocity.y = 0.0f;
-                    } else {
-                        float dir = (position.z < Objects[i]->position.z) ? -1.0f : 1.0f;
-                        position.z += pz * dir;
-                        Objects[i]->velocity.z = velocity.z;
-                        velocity.z = 0;
-                    }
-                }
-            }
-        }
+    if (sharedMesh) {
+        texture.texture = 0; // not ours either
+        return;
     }
-    
-    lastPosition = position;
-}
-
-Element::~Element() {
+    if (!VAO) return; // never init()'d, e.g. physics only elements in the headless bench where there's no GL to call
+    untrackGpuObject(GpuObjectKind::Buffer, VBO);
+    untrackGpuObject(GpuObjectKind::Buffer, EBO);
+    untrackGpuObject(GpuObjectKind::Buffer, positionVBO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteVertexArrays(1, &depthVAO);
+    glDeleteBuffers(1, &positionVBO);
 }
 
 
 void HUDElement::init() {
-    if (useTexture)
+    MEMORY_TAG(MemoryTag::Hud);
+    if (useTexture && !textureFile.empty()) // otherwise the texture was already set up by hand
         texture.init(textureFile);
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
@@ -242,11 +191,13 @@ void HUDElement::init() {
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, VBO, vertices.size() * sizeof(float), MemoryTag::Hud);
 
     glGenBuffers(1, &EBO);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, EBO, indices.size() * sizeof(unsigned int), MemoryTag::Hud);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
@@ -256,6 +207,17 @@ void HUDElement::init() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
     glEnableVertexAttribArray(2);
 };
+void HUDElement::upload() {
+    // orphan and refill, so we don't wait on the gpu still drawing last frame's data
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, VBO, vertices.size() * sizeof(float), MemoryTag::Hud);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_DYNAMIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, EBO, indices.size() * sizeof(unsigned int), MemoryTag::Hud);
+    glBindVertexArray(0);
+}
 void HUDElement::draw() const {
     if (!shader) return;
     shader->use();
@@ -284,13 +246,33 @@ bool HUDElement::getUseTexture() const {
 }
 
 HUDElement::~HUDElement() {
+    if (!VAO) return;
+    untrackGpuObject(GpuObjectKind::Buffer, VBO);
+    untrackGpuObject(GpuObjectKind::Buffer, EBO);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
 }
 
 int addToWorld(Element* e, std::vector<Element*>& Objects) { // very demure, very mindful func
-    e->id = Objects.size()+1;
+    if (e->objects) removeFromWorld(e); // already somewhere
+    e->objects = &Objects;
+    e->objectIndex = Objects.size();
     Objects.push_back(e);
+    pushElement(world, *e); // sets id from the entity
     return e->id;
+}
+
+void removeFromWorld(Element* e) {
+    detachElement(e); // or the graph keeps dragging it around, and a pool hands it out again frozen in place
+    if (e->objects) {
+        std::vector<Element*>& Objects = *e->objects;
+        Element* last = Objects.back();
+        Objects[e->objectIndex] = last;
+        last->objectIndex = e->objectIndex;
+        Objects.pop_back();
+        e->objects = nullptr;
+    }
+    world.destroy(e->entity);
+    e->entity = NO_ENTITY;
 }
\ No newline at end of file
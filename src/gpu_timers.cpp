@@ -0,0 +1,95 @@
+#include <iostream>
+#include <string.h>
+#include <glad/glad.h>
+
+#include "gpu_timers.hpp"
+#include "profiler.hpp"
+
+void GpuTimers::init() {
+    for (Frame& frame : frames)
+        glGenQueries(GPU_TIMER_MAX_ZONES * 2, frame.queries);
+    initialized = true;
+}
+
+void GpuTimers::beginFrame() {
+    if (!initialized) return;
+    frameIndex++;
+    // the slot we're about to reuse holds the oldest frame
+    Frame& frame = frames[frameIndex % GPU_TIMER_FRAMES];
+    if (frame.count > 0)
+        readBack(frame);
+    frame.count = 0;
+    frame.lastIssued = -1;
+}
+
+void GpuTimers::readBack(Frame& frame) {
+    // a zone that was never ended has no end timestamp coming, reading it would wait forever
+    for (int i = 0; i < frame.count; i++) {
+        if (!frame.ended[i]) {
+            missedReadbacks++;
+            return;
+        }
+    }
+    // queries finish in the order they were issued, so if the last one is there so is everything before it
+    int available = 0;
+    glGetQueryObjectiv(frame.queries[frame.lastIssued], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        missedReadbacks++;
+        return;
+    }
+    results.clear();
+    uint64_t first = UINT64_MAX, last = 0;
+    for (int i = 0; i < frame.count; i++) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        results.push_back(GpuTimerResult{frame.names[i], (end - start) / 1000000.0, start, end});
+        if (start < first) first = start;
+        if (end > last) last = end;
+    }
+    frameMilliseconds = (last - first) / 1000000.0;
+
+#ifdef NGENFESH_PROFILE
+    // line the gpu clock up with the profiler's clock right now, so the zones land roughly where they happened
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    int64_t offset = (int64_t)profiler::now() - gpuNow;
+    profiler::ThreadBuffer& timeline = profiler::timelineBuffer("GPU");
+    for (const GpuTimerResult& result : results)
+        profiler::record(timeline, result.name, result.start + offset, result.end + offset);
+#endif
+}
+
+int GpuTimers::begin(const char* name) {
+    if (!initialized) return -1;
+    Frame& frame = frames[frameIndex % GPU_TIMER_FRAMES];
+    if (frame.count >= GPU_TIMER_MAX_ZONES) return -1;
+    int zone = frame.count++;
+    frame.names[zone] = name;
+    frame.ended[zone] = false;
+    glQueryCounter(frame.queries[zone * 2], GL_TIMESTAMP);
+    frame.lastIssued = zone * 2;
+    return zone;
+}
+
+void GpuTimers::end(int zone) {
+    if (zone < 0) return;
+    Frame& frame = frames[frameIndex % GPU_TIMER_FRAMES];
+    glQueryCounter(frame.queries[zone * 2 + 1], GL_TIMESTAMP);
+    frame.ended[zone] = true;
+    frame.lastIssued = zone * 2 + 1;
+}
+
+double GpuTimers::milliseconds(const char* name) const {
+    double total = 0.0;
+    for (const GpuTimerResult& result : results) {
+        if (strcmp(result.name, name) == 0) total += result.milliseconds;
+    }
+    return total;
+}
+
+GpuTimers::~GpuTimers() {
+    if (!initialized) return;
+    for (Frame& frame : frames)
+        glDeleteQueries(GPU_TIMER_MAX_ZONES * 2, frame.queries);
+}
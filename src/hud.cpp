@@ -0,0 +1,269 @@
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "hud.hpp"
+#include "shader_def.hpp"
+#include "util.hpp"
+#include "memory_tracking.hpp"
+
+std::atomic<bool> showPerfHud{false};
+
+// 5x7 font for ascii 32 (space) to 95 (underscore), lowercase gets drawn as uppercase.
+// one byte per row, top row first, bit 4 is the leftmost pixel
+static const unsigned char hudFont[64][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // '!'
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, // '#'
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, // '$'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, // '&'
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, // "'"
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, // '*'
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ','
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, // ';'
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, // '<'
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // '='
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, // '>'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // '?'
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, // '@'
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, // '['
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, // '\\'
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, // ']'
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, // '_'
+};
+
+// the atlas is a 16x5 grid of 8x8 cells: 64 glyphs, then a solid cell and a see-through cell for the panel
+#define ATLAS_WIDTH 128
+#define ATLAS_HEIGHT 40
+#define GLYPH_SCALE 2 // screen pixels per font pixel
+#define SOLID_CELL 64
+#define PANEL_CELL 65
+
+static glm::vec2 cellUV(int cell) {
+    return glm::vec2((cell % 16) * 8.0f / ATLAS_WIDTH, (cell / 16) * 8.0f / ATLAS_HEIGHT);
+}
+
+void PerfHud::init() {
+    MEMORY_TAG(MemoryTag::Hud);
+    std::vector<unsigned char> atlas(ATLAS_WIDTH * ATLAS_HEIGHT * 4, 0);
+    for (int cell = 0; cell < 66; cell++) {
+        int cellX = (cell % 16) * 8, cellY = (cell / 16) * 8;
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                unsigned char alpha = 0;
+                if (cell < 64)
+                    alpha = (y < 7 && x < 5 && (hudFont[cell][y] >> (4 - x)) & 1) ? 255 : 0;
+                else
+                    alpha = cell == SOLID_CELL ? 255 : 170;
+                unsigned char* pixel = &atlas[((cellY + y) * ATLAS_WIDTH + cellX + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = 255;
+                pixel[3] = alpha;
+            }
+        }
+    }
+    text.texture.initPixels(atlas.data(), ATLAS_WIDTH, ATLAS_HEIGHT, GL_RGBA, GL_NEAREST);
+    text.useTexture = true;
+    text.shader = hudShader;
+    text.init();
+
+    graph.draw_mode = GL_LINES;
+    graph.shader = hudShader;
+    graph.init();
+}
+
+void PerfHud::addQuad(glm::vec2 pixelMin, glm::vec2 pixelMax, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec3 color, int width, int height) {
+    // pixels (top left origin) to NDC
+    glm::vec2 ndcMin(pixelMin.x / width * 2.0f - 1.0f, 1.0f - pixelMin.y / height * 2.0f);
+    glm::vec2 ndcMax(pixelMax.x / width * 2.0f - 1.0f, 1.0f - pixelMax.y / height * 2.0f);
+    unsigned int base = text.vertices.size() / 8;
+    float quad[4][4] = {
+        {ndcMin.x, ndcMin.y, uvMin.x, uvMin.y},
+        {ndcMax.x, ndcMin.y, uvMax.x, uvMin.y},
+        {ndcMax.x, ndcMax.y, uvMax.x, uvMax.y},
+        {ndcMin.x, ndcMax.y, uvMin.x, uvMax.y},
+    };
+    for (const float* v : quad) {
+        text.vertices.insert(text.vertices.end(), {v[0], v[1], 0.0f, color.r, color.g, color.b, v[2], v[3]});
+    }
+    text.indices.insert(text.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+void PerfHud::addText(const char* string, glm::vec2 pixelPos, glm::vec3 color, int width, int height) {
+    glm::vec2 glyphSize(5.0f / ATLAS_WIDTH, 7.0f / ATLAS_HEIGHT);
+    for (const char* c = string; *c; c++) {
+        int ch = (unsigned char)*c;
+        if (ch >= 'a' && ch <= 'z') ch -= 'a' - 'A';
+        if (ch < 32 || ch > 95) ch = '?';
+        if (ch != ' ') {
+            glm::vec2 uv = cellUV(ch - 32);
+            addQuad(pixelPos, pixelPos + glm::vec2(5, 7) * (float)GLYPH_SCALE, uv, uv + glyphSize, color, width, height);
+        }
+        pixelPos.x += 6 * GLYPH_SCALE;
+    }
+}
+
+void PerfHud::update(const HudFrameInfo& frame, const Renderer& renderer, int width, int height) {
+    frameTimes[frameCursor] = frame.frameTime;
+    frameCursor = (frameCursor + 1) % HUD_GRAPH_SAMPLES;
+    frameCount = std::min(frameCount + 1, HUD_GRAPH_SAMPLES);
+    physicsTime += frame.physicsTime;
+    physicsSteps += frame.physicsSteps;
+    heapAllocations = std::max(heapAllocations, frame.heapAllocations);
+    bodies = frame.bodies;
+    awakeBodies = frame.awakeBodies;
+    if (frame.inputAge >= 0.0f) {
+        inputAge += frame.inputAge;
+        inputFrames++;
+    }
+    refreshFrames++;
+    sinceRefresh += frame.frameTime;
+    if (!showPerfHud) return;
+    MEMORY_TAG(MemoryTag::Hud);
+
+    if (sinceRefresh >= HUD_TEXT_REFRESH) {
+        rebuildText(renderer, width, height);
+        sinceRefresh = 0.0f;
+        physicsTime = 0.0f;
+        physicsSteps = 0;
+        heapAllocations = 0;
+        refreshFrames = 0;
+        inputAge = 0.0f;
+        inputFrames = 0;
+    }
+    rebuildGraph(width, height);
+}
+
+void PerfHud::rebuildText(const Renderer& renderer, int width, int height) {
+    sorted.assign(frameTimes, frameTimes + frameCount);
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](float p) {
+        if (sorted.empty()) return 0.0f;
+        return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)] * 1000.0f;
+    };
+    float average = 0.0f;
+    for (float t : sorted) average += t;
+    average = sorted.empty() ? 0.0f : average / sorted.size();
+
+    char lines[8][64];
+    snprintf(lines[0], 64, "FRAME %.2f MS  %.0f FPS", average * 1000.0f, average > 0.0f ? 1.0f / average : 0.0f);
+    snprintf(lines[1], 64, "P50 %.2f  P95 %.2f  P99 %.2f", percentile(0.50f), percentile(0.95f), percentile(0.99f));
+    if (inputFrames)
+        snprintf(lines[2], 64, "GPU %.2f MS  INPUT %.2f MS", renderer.gpuTimers.frameMilliseconds, inputAge / inputFrames * 1000.0f);
+    else
+        snprintf(lines[2], 64, "GPU %.2f MS  INPUT -", renderer.gpuTimers.frameMilliseconds);
+    snprintf(lines[3], 64, "PHYSICS %.2f MS  %.1f STEPS", refreshFrames ? physicsTime / refreshFrames * 1000.0f : 0.0f, refreshFrames ? (float)physicsSteps / refreshFrames : 0.0f);
+    snprintf(lines[4], 64, "DRAWS %i (+%i DEPTH)  STATE %i", renderer.stats.drawCalls, renderer.stats.depthDrawCalls, renderer.stats.stateChanges);
+    snprintf(lines[5], 64, "TRIS %i", renderer.stats.triangles);
+    snprintf(lines[6], 64, "AWAKE %i / %i BODIES", awakeBodies, bodies);
+    MemoryTagStats memory = memoryTotals();
+    snprintf(lines[7], 64, "RSS %.1f  HEAP %.1f  GPU %.1f MB  ALLOCS %llu", currentRSS() / (1024.0f * 1024.0f), memory.heapBytes / (1024.0f * 1024.0f),
+        memory.gpuBytes / (1024.0f * 1024.0f), (unsigned long long)heapAllocations);
+
+    text.vertices.clear();
+    text.indices.clear();
+    float lineHeight = 9 * GLYPH_SCALE;
+    glm::vec2 origin(8.0f, 8.0f);
+    // panel behind the text and the graph
+    glm::vec2 panelUV = cellUV(PANEL_CELL) + glm::vec2(4.0f / ATLAS_WIDTH, 4.0f / ATLAS_HEIGHT);
+    size_t longest = 0;
+    for (int i = 0; i < 8; i++) longest = std::max(longest, strlen(lines[i]));
+    float panelWidth = std::max(HUD_GRAPH_SAMPLES * 1.5f, (float)longest * 6 * GLYPH_SCALE);
+    addQuad(origin - 4.0f, origin + glm::vec2(panelWidth + 4.0f, 8 * lineHeight + 64.0f + 8.0f), panelUV, panelUV, glm::vec3(0.0f), width, height);
+    for (int i = 0; i < 8; i++)
+        addText(lines[i], origin + glm::vec2(0.0f, i * lineHeight), glm::vec3(1.0f), width, height);
+    text.upload();
+}
+
+void PerfHud::rebuildGraph(int width, int height) {
+    // frame time from 0 (bottom) to 50 ms (top), newest on the right
+    float graphWidth = HUD_GRAPH_SAMPLES * 1.5f, graphHeight = 64.0f;
+    glm::vec2 origin(8.0f, 8.0f + 8 * 9 * GLYPH_SCALE + 4.0f);
+    auto toNDC = [&](float x, float ms) {
+        float y = origin.y + graphHeight * (1.0f - std::min(ms / 50.0f, 1.0f));
+        return glm::vec2((origin.x + x) / width * 2.0f - 1.0f, 1.0f - y / height * 2.0f);
+    };
+    graph.vertices.clear();
+    graph.indices.clear();
+    auto addLine = [&](glm::vec2 a, glm::vec2 b, glm::vec3 color) {
+        unsigned int base = graph.vertices.size() / 8;
+        graph.vertices.insert(graph.vertices.end(), {a.x, a.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f});
+        graph.vertices.insert(graph.vertices.end(), {b.x, b.y, 0.0f, color.r, color.g, color.b, 0.0f, 0.0f});
+        graph.indices.insert(graph.indices.end(), {base, base + 1});
+    };
+    // 60 and 30 fps
+    addLine(toNDC(0.0f, 1000.0f / 60.0f), toNDC(graphWidth, 1000.0f / 60.0f), glm::vec3(0.2f, 0.5f, 0.2f));
+    addLine(toNDC(0.0f, 1000.0f / 30.0f), toNDC(graphWidth, 1000.0f / 30.0f), glm::vec3(0.5f, 0.2f, 0.2f));
+    int oldest = (frameCursor - frameCount + HUD_GRAPH_SAMPLES) % HUD_GRAPH_SAMPLES;
+    for (int i = 1; i < frameCount; i++) {
+        float a = frameTimes[(oldest + i - 1) % HUD_GRAPH_SAMPLES] * 1000.0f;
+        float b = frameTimes[(oldest + i) % HUD_GRAPH_SAMPLES] * 1000.0f;
+        glm::vec3 color = b < 1000.0f / 55.0f ? glm::vec3(0.3f, 1.0f, 0.3f) : b < 1000.0f / 30.0f ? glm::vec3(1.0f, 0.9f, 0.2f) : glm::vec3(1.0f, 0.3f, 0.2f);
+        float x = graphWidth * (HUD_GRAPH_SAMPLES - frameCount + i) / HUD_GRAPH_SAMPLES;
+        addLine(toNDC(x - graphWidth / HUD_GRAPH_SAMPLES, a), toNDC(x, b), color);
+    }
+    graph.upload();
+}
+
+void PerfHud::draw() const {
+    if (!showPerfHud) return;
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glActiveTexture(GL_TEXTURE0);
+    hudShader->use();
+    hudShader->setInt("Texture", 0);
+    text.draw();
+    graph.draw();
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "input.hpp"
+
+InputBindings inputBindings;
+
+static const char* actionNames[ACTION_COUNT] = {
+    "forward", "back", "left", "right", "jump",
+    "pickup", "rocket", "rotate_x", "rotate_y", "rotate_z",
+    "toggle_debug", "toggle_deferred", "toggle_prepass", "dump_trace", "perf_hud", "memory_report",
+    "release_mouse"
+};
+
+const char* actionName(Action action) {
+    return actionNames[(int)action];
+}
+
+InputBindings::InputBindings() {
+    bind(Action::MoveForward, GLFW_KEY_W);
+    bind(Action::MoveBack, GLFW_KEY_S);
+    bind(Action::MoveLeft, GLFW_KEY_A);
+    bind(Action::MoveRight, GLFW_KEY_D);
+    bind(Action::Jump, GLFW_KEY_SPACE);
+    bind(Action::Pickup, GLFW_KEY_E);
+    bind(Action::Rocket, GLFW_KEY_F);
+    bind(Action::RotateX, GLFW_KEY_H);
+    bind(Action::RotateY, GLFW_KEY_J);
+    bind(Action::RotateZ, GLFW_KEY_K);
+    bind(Action::ToggleDebug, GLFW_KEY_P);
+    bind(Action::ToggleDeferred, GLFW_KEY_G);
+    bind(Action::TogglePrepass, GLFW_KEY_Z);
+    bind(Action::DumpTrace, GLFW_KEY_F9);
+    bind(Action::TogglePerfHud, GLFW_KEY_F3);
+    bind(Action::MemoryReport, GLFW_KEY_F4);
+    bind(Action::ReleaseMouse, GLFW_KEY_ESCAPE);
+}
+
+void InputBindings::bind(Action action, int key) {
+    keys[(int)action] = key;
+}
+
+static int parseKey(const char* name) {
+    if (name[0] && !name[1]) {
+        // glfw's printable keys are their uppercase ascii
+        int c = toupper((unsigned char)name[0]);
+        if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || strchr(",-./;=[\\]`'", c)) return c;
+        return -1;
+    }
+    if (strcmp(name, "space") == 0) return GLFW_KEY_SPACE;
+    if (strcmp(name, "escape") == 0) return GLFW_KEY_ESCAPE;
+    if (strcmp(name, "enter") == 0) return GLFW_KEY_ENTER;
+    if (strcmp(name, "tab") == 0) return GLFW_KEY_TAB;
+    if ((name[0] == 'f' || name[0] == 'F') && isdigit((unsigned char)name[1])) {
+        int n = atoi(name + 1);
+        return (n >= 1 && n <= 12) ? GLFW_KEY_F1 + n - 1 : -1;
+    }
+    char* end = nullptr;
+    long code = strtol(name, &end, 10);
+    if (end == name || *end || code < 0 || code >= 512) return -1;
+    return (int)code;
+}
+
+bool InputBindings::parse(const char* binding) {
+    const char* equals = strchr(binding, '=');
+    if (!equals) {
+        printf("input.cpp: binding %s should look like action=key\n", binding);
+        return false;
+    }
+    std::string name(binding, equals - binding);
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        if (name != actionNames[i]) continue;
+        int key = parseKey(equals + 1);
+        if (key < 0) {
+            printf("input.cpp: don't know the key %s\n", equals + 1);
+            return false;
+        }
+        bind((Action)i, key);
+        return true;
+    }
+    printf("input.cpp: no action called %s\n", name.c_str());
+    return false;
+}
+
+std::vector<int> InputBindings::boundKeys() const {
+    std::vector<int> bound;
+    for (int key : keys) {
+        bool seen = false;
+        for (int other : bound) seen |= other == key;
+        if (!seen) bound.push_back(key);
+    }
+    return bound;
+}
+
+void updateActions(ActionState& actions, const KeyState keys[512], const InputBindings& bindings) {
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        int key = bindings.key((Action)i);
+        const KeyState& state = keys[key];
+        actions.held[i] = state.currentState;
+        actions.pressed[i] = state.currentState && !state.pastState;
+    }
+}
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <math.h>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "lighting.hpp"
+#include "memory_tracking.hpp"
+
+float calcLightRange(const ElementDrawState& light) {
+    // solve intensity / (constant + linear*d + quadratic*d^2) = LIGHT_CUTOFF for d
+    float intensity = std::max(std::max(light.pointLightColor.r, light.pointLightColor.g), light.pointLightColor.b) * (1.0f + light.pointLightSpecStrength);
+    float c = light.pointLightConstant - intensity / LIGHT_CUTOFF;
+    float l = light.pointLightLinear;
+    float q = light.pointLightQuadratic;
+    if (c >= 0.0f) return 0.0f; // too dim to ever matter
+    if (q <= 0.0f) {
+        if (l <= 0.0f) return FLT_MAX; // no falloff at all, reaches everything
+        return -c / l;
+    }
+    return (-l + sqrtf(l*l - 4.0f*q*c)) / (2.0f*q);
+}
+
+void LightClusters::init() {
+    MEMORY_TAG(MemoryTag::Lighting);
+    glGenBuffers(1, &lightSSBO);
+    glGenBuffers(1, &clusterSSBO);
+    glGenBuffers(1, &indexSSBO);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_COUNT * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_DRAW);
+    trackGpuObject(GpuObjectKind::Buffer, clusterSSBO, CLUSTER_COUNT * sizeof(glm::uvec2), MemoryTag::Lighting);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    clusterRanges.resize(CLUSTER_COUNT);
+    minX.resize(CLUSTER_COUNT); minY.resize(CLUSTER_COUNT); minZ.resize(CLUSTER_COUNT);
+    maxX.resize(CLUSTER_COUNT); maxY.resize(CLUSTER_COUNT); maxZ.resize(CLUSTER_COUNT);
+}
+
+int LightClusters::sliceFromDepth(float depth) const {
+    // exponential slices, so clusters near the camera are thin and far ones are deep
+    int slice = (int)floorf(logf(depth / zNear) * CLUSTER_Z / logf(zFar / zNear));
+    return std::clamp(slice, 0, CLUSTER_Z - 1);
+}
+
+// only needs to happen when the projection changes (resize, fov)
+void LightClusters::buildClusterBounds(const glm::mat4& projection) {
+    glm::mat4 invProjection = glm::inverse(projection);
+    for (int z = 0; z < CLUSTER_Z; z++) {
+        float sliceNear = zNear * powf(zFar / zNear, (float)z / CLUSTER_Z);
+        float sliceFar = zNear * powf(zFar / zNear, (float)(z + 1) / CLUSTER_Z);
+        for (int y = 0; y < CLUSTER_Y; y++) {
+            for (int x = 0; x < CLUSTER_X; x++) {
+                glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+                for (int corner = 0; corner < 4; corner++) {
+                    float ndcX = -1.0f + 2.0f * (float)(x + (corner & 1)) / CLUSTER_X;
+                    float ndcY = -1.0f + 2.0f * (float)(y + (corner >> 1)) / CLUSTER_Y;
+                    glm::vec4 onNear = invProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                    glm::vec3 dir = glm::vec3(onNear) / onNear.w;
+                    // walk the ray through this tile corner out to the slice's near and far depth
+                    glm::vec3 p1 = dir * (sliceNear / -dir.z);
+                    glm::vec3 p2 = dir * (sliceFar / -dir.z);
+                    bmin = glm::min(bmin, glm::min(p1, p2));
+                    bmax = glm::max(bmax, glm::max(p1, p2));
+                }
+                int i = x + CLUSTER_X * (y + CLUSTER_Y * z);
+                minX[i] = bmin.x; minY[i] = bmin.y; minZ[i] = bmin.z;
+                maxX[i] = bmax.x; maxY[i] = bmax.y; maxZ[i] = bmax.z;
+            }
+        }
+    }
+    lastProjection = projection;
+}
+
+void LightClusters::update(const std::vector<ElementDrawState*>& lights, const glm::mat4& view, const glm::mat4& projection, float aZNear, float aZFar) {
+    MEMORY_TAG(MemoryTag::Lighting);
+    if (projection != lastProjection || aZNear != zNear || aZFar != zFar) {
+        zNear = aZNear;
+        zFar = aZFar;
+        buildClusterBounds(projection);
+    }
+
+    // how many clusters a light touches depends on where the camera is, so growing on demand would keep
+    // allocating every time the view moves somewhere new. size for every light in every cluster instead,
+    // that only changes when lights are added
+    if (lights.size() > reservedLights) {
+        reservedLights = lights.size();
+        gpuLights.reserve(reservedLights);
+        pairs.reserve(reservedLights * CLUSTER_COUNT);
+        lightIndices.reserve(reservedLights * CLUSTER_COUNT);
+    }
+    gpuLights.clear();
+    pairs.clear();
+    for (glm::uvec2& range : clusterRanges) range = glm::uvec2(0);
+
+    for (const ElementDrawState* light : lights) {
+        float range = calcLightRange(*light);
+        if (range <= 0.0f) continue;
+        unsigned int lightIndex = gpuLights.size();
+        gpuLights.push_back(GpuPointLight{
+            glm::vec4(light->position, range),
+            glm::vec4(light->pointLightColor, light->pointLightSpecStrength),
+            glm::vec4(light->pointLightConstant, light->pointLightLinear, light->pointLightQuadratic, (float)light->shadowSlot)
+        });
+
+        glm::vec3 p = glm::vec3(view * glm::vec4(light->position, 1.0f));
+        float depth = -p.z;
+        if (depth + range < zNear || depth - range > zFar) continue; // behind us or past the far plane
+
+        int z0 = sliceFromDepth(std::max(depth - range, zNear));
+        int z1 = sliceFromDepth(std::min(depth + range, zFar));
+        int x0 = 0, x1 = CLUSTER_X - 1, y0 = 0, y1 = CLUSTER_Y - 1;
+        if (depth - range > zNear) {
+            // sphere is fully in front of the camera, project its box to find which tiles it can cover
+            glm::vec2 ndcMin(FLT_MAX), ndcMax(-FLT_MAX);
+            for (int corner = 0; corner < 8; corner++) {
+                glm::vec3 c = p + glm::vec3((corner & 1) ? range : -range, (corner & 2) ? range : -range, (corner & 4) ? range : -range);
+                glm::vec4 clip = projection * glm::vec4(c, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue; // off screen
+            x0 = std::clamp((int)floorf((ndcMin.x * 0.5f + 0.5f) * CLUSTER_X), 0, CLUSTER_X - 1);
+            x1 = std::clamp((int)floorf((ndcMax.x * 0.5f + 0.5f) * CLUSTER_X), 0, CLUSTER_X - 1);
+            y0 = std::clamp((int)floorf((ndcMin.y * 0.5f + 0.5f) * CLUSTER_Y), 0, CLUSTER_Y - 1);
+            y1 = std::clamp((int)floorf((ndcMax.y * 0.5f + 0.5f) * CLUSTER_Y), 0, CLUSTER_Y - 1);
+        }
+
+        float rangeSq = range * range;
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                int row = CLUSTER_X * (y + CLUSTER_Y * z);
+                for (int x = x0; x <= x1; x++) {
+                    int i = row + x;
+                    // squared distance from the light to the closest point of the cluster box
+                    float dx = std::max(std::max(minX[i] - p.x, 0.0f), p.x - maxX[i]);
+                    float dy = std::max(std::max(minY[i] - p.y, 0.0f), p.y - maxY[i]);
+                    float dz = std::max(std::max(minZ[i] - p.z, 0.0f), p.z - maxZ[i]);
+                    if (dx*dx + dy*dy + dz*dz <= rangeSq) {
+                        pairs.push_back(glm::uvec2(i, lightIndex));
+                        clusterRanges[i].y++;
+                    }
+                }
+            }
+        }
+    }
+
+    // prefix sum the counts into offsets, then scatter light indices into one tightly packed list
+    unsigned int offset = 0;
+    for (glm::uvec2& range : clusterRanges) {
+        range.x = offset;
+        offset += range.y;
+        range.y = 0;
+    }
+    lightIndices.resize(pairs.size());
+    for (const glm::uvec2& pair : pairs) {
+        glm::uvec2& range = clusterRanges[pair.x];
+        lightIndices[range.x + range.y] = pair.y;
+        range.y++;
+    }
+    lightCount = gpuLights.size();
+    assignedCount = pairs.size();
+
+    // upload, only reallocating the buffers when they need to grow
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightSSBO);
+    if (gpuLights.capacity() > lightCapacity || lightCapacity == 0) {
+        lightCapacity = std::max(gpuLights.capacity(), (size_t)16);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, lightCapacity * sizeof(GpuPointLight), nullptr, GL_DYNAMIC_DRAW);
+        trackGpuObject(GpuObjectKind::Buffer, lightSSBO, lightCapacity * sizeof(GpuPointLight), MemoryTag::Lighting);
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuLights.size() * sizeof(GpuPointLight), gpuLights.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexSSBO);
+    if (lightIndices.capacity() > indexCapacity || indexCapacity == 0) {
+        indexCapacity = std::max(lightIndices.capacity(), (size_t)256);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, indexCapacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+        trackGpuObject(GpuObjectKind::Buffer, indexSSBO, indexCapacity * sizeof(unsigned int), MemoryTag::Lighting);
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, lightIndices.size() * sizeof(unsigned int), lightIndices.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusterSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, clusterRanges.size() * sizeof(glm::uvec2), clusterRanges.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void LightClusters::bind(Shader& shader, float screenWidth, float screenHeight) const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, clusterSSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indexSSBO);
+    shader.use();
+    shader.setFloat("zNear", zNear);
+    shader.setFloat("zFar", zFar);
+    shader.setVec2("screenSize", glm::vec2(screenWidth, screenHeight));
+    shader.setIVec3("clusterDims", glm::ivec3(CLUSTER_X, CLUSTER_Y, CLUSTER_Z));
+}
+
+LightClusters::~LightClusters() {
+    untrackGpuObject(GpuObjectKind::Buffer, lightSSBO);
+    untrackGpuObject(GpuObjectKind::Buffer, clusterSSBO);
+    untrackGpuObject(GpuObjectKind::Buffer, indexSSBO);
+    glDeleteBuffers(1, &lightSSBO);
+    glDeleteBuffers(1, &clusterSSBO);
+    glDeleteBuffers(1, &indexSSBO);
+}
@@ -3,7 +3,10 @@
 #include <GLFW/glfw3.h>
 
 #include <math.h>
+#include <string.h>
 #include <random>
+#include <mutex>
+#include <thread>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -17,6 +20,15 @@
 #include "premade_elements.hpp"
 #include "player.hpp"
 #include "shader_def.hpp"
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "hud.hpp"
+#include "replay.hpp"
+#include "memory_tracking.hpp"
+#include "systems.hpp"
+#include "render_snapshot.hpp"
+#include "input.hpp"
+#include "scene_graph.hpp"
 
 float windowWidth = 512.0f;
 float windowHeight = 512.0f;
@@ -33,47 +45,119 @@ Player defaultPlayer; // doing this for support for multiple players in the futu
 Player* controlledPlayer = &defaultPlayer;
 bool inMenu = false;
 float currentFrame = 0.0f, deltaTime = 0.0f, lastFrame = 0.0f;
+// fixed physics steps per second, rendering interpolates in between so 30 still looks smooth at 144fps.
+// a replay has to be played back at the rate it was recorded at
+float physicsRate = 60.0f;
+#define MAX_PHYSICS_STEPS_PER_FRAME 8
+float physicsAccumulator = 0.0f;
+// --threaded runs simulateFrame on its own thread, one frame ahead of the renderer
+bool threadedSim = false;
+
+KeyState keys[512] = {}; // simulation side, updated from each frame's key mask
+ActionState actions; // keys through inputBindings, what Player::keyInput goes by
+
+InputRecorder inputRecorder; // --record / --replay
+InputFrame frameInput; // the simulation's current frame of keys and mouse movement, live or replayed
+
+// main thread only. the callbacks queue events, pumpInput turns them into which keys are down
+InputQueue inputQueue;
+bool keyDown[512] = {};
+bool keyTapped[512] = {}; // went down since the last sampleInput, so a tap shorter than a frame still counts
+glm::dvec2 sampledMouse{0.0}; // all the mouse movement ever handed to the simulation
+double newestMouseTime = 0.0; // when the newest mouse event in sampledMouse happened
+
+// what sampleInput saw last, waiting for the simulation to take it. with --threaded that's another thread
+std::mutex liveInputMutex;
+std::vector<int> liveKeyCodes; // inputBindings.boundKeys(), bit i of liveKeyMask is liveKeyCodes[i]
+uint64_t liveKeyMask = 0;
+glm::vec2 liveMouse{0.0f};
+glm::dvec2 takenMouse{0.0}; // sampledMouse as of the simulation's last take, lands in RenderSnapshot::mouseTaken
+
+// turns the mouse movement into camera yaw/pitch
+void applyMouse(glm::vec2 offset) {
+    offset *= MOUSE_SENSITIVITY;
+    controlledPlayer->camera()->setYaw(controlledPlayer->camera()->getYaw()+offset.x);
+    controlledPlayer->camera()->setPitch(controlledPlayer->camera()->getPitch()+offset.y);
+}
 
-KeyState keys[512] = {};
-int keysToCheck[512] = {
-    GLFW_KEY_W,
-    GLFW_KEY_A,
-    GLFW_KEY_S,
-    GLFW_KEY_D,
-    GLFW_KEY_E,
-    GLFW_KEY_F,
-    GLFW_KEY_SPACE,
-    GLFW_KEY_ESCAPE,
-    GLFW_KEY_H,
-    GLFW_KEY_J,
-    GLFW_KEY_K,
-    GLFW_KEY_P
-}; // if this gets bigger, more complex, user defined keys, etc, more complex input system should be made
-//                                                               including callbacks, etc
-
-void processInput(GLFWwindow* window) {
-    // if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS){ /*glfwSetWindowShouldClose(window, true);*/
-
-    // }
-    for (int key : keysToCheck) {
-        int keyState = glfwGetKey(window, key);
-        if (keyState == GLFW_PRESS) {
-            keys[key].pastState = keys[key].currentState;
-            keys[key].currentState = true;
-            // if (keys[key].currentState != keys[key].pastState)
-                // printf("%c PRESSED    CUR: %i PREV: %i\n", key, keys[key].currentState, keys[key].pastState);
+// main thread, empties the queue the callbacks filled during glfwPollEvents
+void pumpInput(GLFWwindow* window) {
+    glm::vec2 mouse(0.0f);
+    inputQueue.drain([&](const InputEvent& event) {
+        if (event.type == InputEvent::MouseMove) {
+            mouse += event.delta;
+            newestMouseTime = event.time;
+            return;
         }
-        if (keyState == GLFW_RELEASE) {
-            keys[key].pastState = keys[key].currentState;
-            keys[key].currentState = false;
-            // if (keys[key].currentState != keys[key].pastState)
-                // printf("%c IS RELEASED       CUR: %i PREV: %i\n", key, keys[key].currentState, keys[key].pastState);
+        if (event.key < 0 || event.key >= 512) return;
+        if (event.pressed && !keyDown[event.key]) keyTapped[event.key] = true;
+        keyDown[event.key] = event.pressed;
+        // releasing the mouse is the window's business so it's handled here and not by the player
+        if (event.pressed && event.key == inputBindings.key(Action::ReleaseMouse)) {
+            if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_NORMAL)
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+            else
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
         }
+    });
+    if (mouse == glm::vec2(0.0f)) return;
+    sampledMouse += glm::dvec2(mouse);
+    std::lock_guard<std::mutex> lock(liveInputMutex);
+    liveMouse += mouse;
+}
+
+// main thread, hands the keys that are down to the simulation
+void sampleInput(GLFWwindow* window) {
+    pumpInput(window);
+    uint64_t mask = 0;
+    for (size_t i = 0; i < liveKeyCodes.size(); i++) {
+        int key = liveKeyCodes[i];
+        if (keyDown[key] || keyTapped[key]) mask |= (uint64_t)1 << i;
+        keyTapped[key] = false;
+    }
+    std::lock_guard<std::mutex> lock(liveInputMutex);
+    liveKeyMask = mask;
+}
+
+// main thread, right before the frame is submitted: whatever the mouse did since the simulation took its input
+// goes straight into the snapshot's camera, so looking around is up to a frame fresher than the simulation.
+// the simulation still gets the same movement with its next take, so the view ends up in the same place.
+// replays already have their camera exactly where the recording had it
+void latchCamera(GLFWwindow* window, RenderSnapshot& snapshot, HudFrameInfo& hudFrame) {
+    PROFILE_SCOPE("latchCamera");
+    hudFrame.inputAge = -1.0f;
+    if (inputRecorder.replaying()) return;
+    glfwPollEvents();
+    pumpInput(window);
+    glm::vec2 offset = glm::vec2(sampledMouse - snapshot.mouseTaken) * MOUSE_SENSITIVITY;
+    snapshot.camera.turn(offset.x, offset.y);
+    static double latchedMouseTime = 0.0;
+    if (newestMouseTime > latchedMouseTime) { // only frames that show new movement say anything about latency
+        hudFrame.inputAge = glfwGetTime() - newestMouseTime;
+        latchedMouseTime = newestMouseTime;
     }
-    controlledPlayer->keyInput(deltaTime, keys, window);
 }
 
-// handle mouse movement, change pitch/yaw of mainCamera to match that of the mouse x and y offset
+// simulation side, live or replayed the frame goes through the same pastState/currentState update
+void applyInput(const InputFrame& frame) {
+    const std::vector<int>& keyCodes = inputRecorder.replaying() ? inputRecorder.keyCodes : liveKeyCodes;
+    for (size_t i = 0; i < keyCodes.size(); i++) {
+        int key = keyCodes[i];
+        if (key < 0 || key >= 512) continue;
+        keys[key].pastState = keys[key].currentState;
+        keys[key].currentState = (frame.keyMask >> i) & 1;
+    }
+    applyMouse(frame.mouseDelta);
+    updateActions(actions, keys, inputBindings);
+    controlledPlayer->keyInput(deltaTime, actions);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action == GLFW_REPEAT) return;
+    inputQueue.push(InputEvent{InputEvent::Key, glfwGetTime(), key, action == GLFW_PRESS, glm::vec2(0.0f)});
+}
+
+// handle mouse movement, queued as how far the cursor moved
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (!controlledPlayer || !controlledPlayer->camera()) {
         std::cerr << "Player or camera is null!" << std::endl;
@@ -83,13 +167,7 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     float yoffset = lastMouseY - ypos;
     lastMouseX = xpos;
     lastMouseY = ypos;
-
-    const float sensitivity = 0.1f;
-    xoffset *= sensitivity;
-    yoffset *= sensitivity;
-
-    controlledPlayer->camera()->setYaw(controlledPlayer->camera()->getYaw()+xoffset);
-    controlledPlayer->camera()->setPitch(controlledPlayer->camera()->getPitch()+yoffset);
+    inputQueue.push(InputEvent{InputEvent::MouseMove, glfwGetTime(), 0, false, glm::vec2(xoffset, yoffset)});
 }
 
 GLFWwindow* initWindow() {
@@ -115,21 +193,112 @@ GLFWwindow* initWindow() {
     // callbacks
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     return window;
 }
 
-int main() {
+std::vector<float> simTimes; // per frame, seconds, reported as percentiles when recording or replaying
+
+// one frame of everything that isn't drawing: input, the player, physics, Element::update, then a snapshot of
+// the result for the renderer. on the main thread, or on its own with --threaded. false once a replay is over
+bool simulateFrame(std::vector<Element*>& Objects, RenderSnapshot& snapshot) {
+    PROFILE_SCOPE("simulate");
+    if (inputRecorder.replaying()) {
+        if (!inputRecorder.nextFrame(frameInput)) return false; // recording is over
+    } else {
+        std::lock_guard<std::mutex> lock(liveInputMutex);
+        frameInput.keyMask = liveKeyMask;
+        frameInput.mouseDelta = liveMouse;
+        takenMouse += glm::dvec2(liveMouse);
+        liveMouse = glm::vec2(0.0f);
+    }
+    snapshot.mouseTaken = takenMouse;
+    {
+        PROFILE_SCOPE("processInput");
+        applyInput(frameInput);
+    }
+    currentFrame = glfwGetTime();
+    if (inputRecorder.replaying()) {
+        deltaTime = frameInput.deltaTime; // the recorded clock, so the simulation plays out exactly the same
+    } else {
+        deltaTime = currentFrame - lastFrame;
+        frameInput.deltaTime = deltaTime;
+        inputRecorder.recordFrame(frameInput);
+    }
+    lastFrame = currentFrame;
+    double simStart = glfwGetTime();
+    {
+        PROFILE_SCOPE("Player::update");
+        controlledPlayer->update();
+    }
+    float dt = 1.0f/physicsRate;
+    physicsAccumulator += deltaTime;
+    // spiral of death: a frame that needs more steps takes longer, which needs even more steps next frame.
+    // past a few steps we drop the time instead and the game runs slower for a bit
+    if (physicsAccumulator > dt * MAX_PHYSICS_STEPS_PER_FRAME) physicsAccumulator = dt * MAX_PHYSICS_STEPS_PER_FRAME;
+    {
+        PROFILE_SCOPE("physics");
+        MEMORY_TAG(MemoryTag::Physics);
+        double physicsStart = glfwGetTime();
+        snapshot.physicsSteps = 0;
+        pushElements(world); // whatever the player/pickups did to Elements since last frame
+        while (physicsAccumulator >= dt) {
+            PROFILE_SCOPE("physics step");
+            physicsStep(world, dt);
+            physicsAccumulator -= dt;
+            snapshot.physicsSteps++;
+        }
+        pullElements(world);
+        interpolateElements(world, physicsAccumulator / dt);
+        snapshot.physicsTime = glfwGetTime() - physicsStart;
+    }
+    {
+        PROFILE_SCOPE("Element::update");
+        for (Element* e : Objects) {
+            e->update(deltaTime);
+        }
+    }
+    controlledPlayer->updateCamera();
+    updateSceneGraph();
+    captureSnapshot(snapshot, Objects, PointLights, *controlledPlayer->camera());
+    if (inputRecorder.recording() || inputRecorder.replaying())
+        simTimes.push_back(glfwGetTime() - simStart);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    // anything allocated from here on and still alive after main's locals are gone shows up as a leak
+    memoryCheckpoint();
+    atexit(printLeakReport);
     // std::random_device rd;
     // std::mt19937 gen(rd());
     // std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
 
     GLFWwindow* window = initWindow();
-    // glfwSetKeyCallback(window, key_callback);
     if (window == NULL) {
         std::cerr << "Error creating window! Closing..";
         return -1;
     }
+    const char* recordPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc)
+            inputBindings.parse(argv[++i]);
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            if (!inputRecorder.startReplay(argv[++i])) return -1;
+        } else if (strcmp(argv[i], "--physics-hz") == 0 && i + 1 < argc) {
+            physicsRate = atof(argv[++i]);
+            if (physicsRate <= 0.0f) physicsRate = 60.0f;
+        } else if (strcmp(argv[i], "--threaded") == 0)
+            threadedSim = true;
+        else
+            printf("main.cpp: unknown argument %s (use --record file, --replay file, --bind action=key, --physics-hz rate or --threaded)\n", argv[i]);
+    }
+    // recordings store the bound keys, not the actions, so replay with the same --binds
+    liveKeyCodes = inputBindings.boundKeys();
+    if (recordPath) inputRecorder.startRecording(recordPath, liveKeyCodes.data(), liveKeyCodes.size());
     initShaders();
     std::vector<Element*> Objects; // create Objects list
 
@@ -147,8 +316,7 @@ int main() {
     // playerBB.sizex = 1.0f;
     // playerBB.sizey = 1.0f;
     // playerBB.sizez = 1.0f;
-    // // wall1.rotate = true;
-    // playerBB.rotation = glm::vec3(1.0f,0.0f,0.0f);
+    // playerBB.setRotation(glm::vec3(1.0f,0.0f,0.0f));
     // playerBB.anchored = true;
     // playerBB.hasCollision = false;
     // // cubeBB.draw_mode = GL_LINES;
@@ -158,6 +326,7 @@ int main() {
     // controlledPlayer->playerElement.debugElement = &playerBB;
 
     // start creating objects
+    MEMORY_TAG(MemoryTag::Meshes);
     Element quad;
     quad.vertices = {QUAD_VERTICES};
     quad.indices = {QUAD_INDICES};
@@ -176,102 +345,16 @@ int main() {
     quad.init();
     addToWorld(&quad, Objects);
 
-    Element quadBB;
-    quadBB.debug = true;
-    quadBB.vertices = calcBoundingBoxVerts(quad.bounding_box_corner1, quad.bounding_box_corner2, glm::vec3(1.0f,0.0f,0.0f),true);
-    quadBB.indices = {CUBEBB_INDICES};
-    quadBB.hasCollision = false;
-    quad.debugElement = &quadBB;
-    quadBB.init();
-    addToWorld(&quadBB,Objects);
-
-    Element skybox1;
-    skybox1.vertices = {QUAD_VERTICES};
-    skybox1.indices = {QUAD_INDICES};
-    skybox1.useTexture = true;
-    skybox1.textureFile = "textures/sky.jpeg";
-    skybox1.hasCollision = false;
-    skybox1.anchored = true;
-    skybox1.sizex = 20.0f;
-    skybox1.sizey = 1.0f;
-    skybox1.sizez = 20.0f;
-    skybox1.position.x = 0.0f;
-    skybox1.position.y = 30.0f;
-    skybox1.init();
-    addToWorld(&skybox1, Objects);
-    Element skybox2;
-    skybox2.vertices = {QUAD_VERTICES};
-    skybox2.indices = {QUAD_INDICES};
-    skybox2.useTexture = true;
-    skybox2.textureFile = "textures/sky.jpeg";
-    skybox2.hasCollision = false;
-    skybox2.anchored = true;
-    skybox2.sizex = 20.0f;
-    skybox2.sizey = 1.0f;
-    skybox2.sizez = 20.0f;
-    skybox2.position.y = 10.0f;
-    skybox2.position.z = 20.0f;
-    skybox2.rotation = glm::vec3(3.14/2,0.0f,0.0f);
-    skybox2.init();
-    addToWorld(&skybox2, Objects);
-    Element skybox3;
-    skybox3.vertices = {QUAD_VERTICES};
-    skybox3.indices = {QUAD_INDICES};
-    skybox3.useTexture = true;
-    skybox3.textureFile = "textures/sky.jpeg";
-    skybox3.hasCollision = false;
-    skybox3.anchored = true;
-    skybox3.sizex = 20.0f;
-    skybox3.sizey = 1.0f;
-    skybox3.sizez = 20.0f;
-    skybox3.position.y = 10.0f;
-    skybox3.position.z = -20.0f;
-    skybox3.rotation = glm::vec3(3.14/2,0.0f,0.0f);
-    skybox3.init();
-    addToWorld(&skybox3, Objects);
-    Element skybox4;
-    skybox4.vertices = {QUAD_VERTICES};
-    skybox4.indices = {QUAD_INDICES};
-    skybox4.useTexture = true;
-    skybox4.textureFile = "textures/sky.jpeg";
-    skybox4.hasCollision = false;
-    skybox4.anchored = true;
-    skybox4.sizex = 20.0f;
-    skybox4.sizey = 1.0f;
-    skybox4.sizez = 20.0f;
-    skybox4.position.x = 20.0f;
-    skybox4.position.y = 10.0f;
-    skybox4.rotation = glm::vec3(0.0f,0.0f,3.14/2);
-    skybox4.init();
-    addToWorld(&skybox4, Objects);
-    Element skybox5;
-    skybox5.vertices = {QUAD_VERTICES};
-    skybox5.indices = {QUAD_INDICES};
-    skybox5.useTexture = true;
-    skybox5.textureFile = "textures/sky.jpeg";
-    skybox5.hasCollision = false;
-    skybox5.anchored = true;
-    skybox5.sizex = 20.0f;
-    skybox5.sizey = 1.0f;
-    skybox5.sizez = 20.0f;
-    skybox5.position.x = -20.0f;
-    skybox5.position.y = 10.0f;
-    skybox5.rotation = glm::vec3(0.0f,0.0f,3.14/2);
-    skybox5.init();
-    addToWorld(&skybox5, Objects);
-
     Element cube;
     cube.vertices = {CUBE_VERTICES};
     cube.indices = {CUBE_INDICES};
-    std::vector<glm::vec3> cubePoints = calcBoundingBoxPoints(cube.vertices);
+    std::array<glm::vec3, 2> cubePoints = calcBoundingBoxPoints(cube.vertices);
     cube.bounding_box_corner1 = cubePoints[0];
     cube.bounding_box_corner2 = cubePoints[1];
     cube.position.x = 5.0f;
     cube.position.y = 2.0f;
     cube.useTexture = true;
-    cube.rotate = true;
-    // cube.rotateAxis = glm::vec3(1.0f, 1.0f, 2.0f);
-    // cube.rotationSpeed = 5.0f;
+    // cube.angularVelocity = glm::vec3(1.0f, 1.0f, 2.0f);
     cube.pivot = glm::vec3(0.0f, 0.0f, 0.0f);
     cube.textureFile = "textures/lungfesh.png";
     for (size_t i = 0; i < cube.vertices.size(); i=i+11) {
@@ -282,15 +365,6 @@ int main() {
     cube.init();
     addToWorld(&cube, Objects);
 
-    Element cubeBB;
-    cubeBB.debug = true;
-    cubeBB.vertices = calcBoundingBoxVerts(cube.bounding_box_corner1, cube.bounding_box_corner2, glm::vec3(1.0f,0.0f,0.0f),true);
-    cubeBB.indices = {CUBEBB_INDICES};
-    cubeBB.hasCollision = false;
-    cube.debugElement = &cubeBB;
-    cubeBB.init();
-    addToWorld(&cubeBB,Objects);
-
     Element wall1;
     wall1.vertices = {QUAD_VERTICES};
     for (size_t i = 0; i < wall1.vertices.size(); i=i+11) { // change wall1 colour to red, should probably make a function for this
@@ -299,21 +373,13 @@ int main() {
         wall1.vertices[i+5] = 0.0f;
     }
     wall1.indices = {QUAD_INDICES};
-    std::vector<glm::vec3> wall1Points = calcBoundingBoxPoints(wall1.vertices);
+    std::array<glm::vec3, 2> wall1Points = calcBoundingBoxPoints(wall1.vertices);
     wall1.bounding_box_corner1 = wall1Points[0] - .1f;
     wall1.bounding_box_corner2 = wall1Points[1];
     wall1.position = glm::vec3(2.0f, 2.0f, 4.0f);
     wall1.init();
     addToWorld(&wall1,Objects);
 
-    Element wall1BB;
-    wall1BB.debug = true;
-    wall1BB.vertices = calcBoundingBoxVerts(wall1.bounding_box_corner1, wall1.bounding_box_corner2, glm::vec3(1.0f,0.0f,0.0f),true);
-    wall1BB.indices = {CUBEBB_INDICES};
-    wall1BB.hasCollision = false;
-    wall1.debugElement = &wall1BB;
-    wall1BB.init();
-    addToWorld(&wall1BB,Objects);
   
     Element lightSource;
     lightSource.vertices = {CUBE_VERTICES};
@@ -336,48 +402,90 @@ int main() {
     }
     lightSource.shader = debugShader;
 
-    float dt = 1.0f/60.0f;
-    float accumulator = 0.0f;
+    MEMORY_TAG(MemoryTag::General); // done with the scene, the rest tags itself
+    Renderer renderer;
+    renderer.init(windowWidth, windowHeight);
+    renderer.sun.color = glm::vec3(0.25f, 0.24f, 0.22f); // dim sun so the cascades have something to do
+    renderer.skybox.init(std::vector<std::string>(6, "textures/sky.jpeg"));
+    PerfHud hud;
+    hud.init();
+    HudFrameInfo hudFrame;
 
     glEnable(GL_DEPTH_TEST);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    while (!glfwWindowShouldClose(window)) {
-        processInput(window);
-        currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        controlledPlayer->update();
-        accumulator += deltaTime;
-        while (accumulator >= dt) {
-            for (Element* e : Objects) {
-                e->physics_step(dt,Objects);
+    PROFILE_THREAD_NAME("main");
+    // wall clock frame time, reported as percentiles when recording or replaying
+    std::vector<float> frameTimes;
+    double lastFrameStart = glfwGetTime();
+    uint64_t lastAllocations = heapAllocations();
+
+    RenderSnapshot snapshot; // single threaded, simulated into and drawn straight away
+    SnapshotBuffer snapshots; // threaded
+    std::thread simThread;
+    if (threadedSim) {
+        // the sim thread never touches GL, the window or anything the renderer owns. it only hands over snapshots
+        simThread = std::thread([&]() {
+            PROFILE_THREAD_NAME("sim");
+            while (simulateFrame(Objects, snapshots.writing())) {
+                if (!snapshots.publish()) break; // window closed
             }
-            accumulator -= dt;    
-        } 
+            snapshots.close(); // replay ran out, let the render loop finish too
+        });
+        printf("main.cpp: simulating on its own thread\n");
+    }
+    while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("frame");
+        double frameStart = glfwGetTime();
+        float wallFrameTime = frameStart - lastFrameStart;
+        lastFrameStart = frameStart;
+        {
+            PROFILE_SCOPE("sampleInput");
+            sampleInput(window);
+        }
+        RenderSnapshot* drawing = &snapshot;
+        if (threadedSim) {
+            // once we have this one the sim thread is free to start on the next, while we draw
+            PROFILE_SCOPE("wait for snapshot");
+            drawing = snapshots.acquire();
+            if (!drawing) break;
+        } else if (!simulateFrame(Objects, snapshot))
+            break;
+        if (inputRecorder.recording() || inputRecorder.replaying())
+            frameTimes.push_back(wallFrameTime);
         // now onto rendering
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glClearColor(0.0f,0.0f,0.0f,1.0f);
-
-        glm::mat4 projection;
-        projection = glm::perspective(glm::radians(75.0f), windowWidth / windowHeight, 0.1f, 100.0f);
-        objectShader->use();
-        for (size_t i = 0; i < PointLights.size(); i++) {
-            objectShader->setVec3("pointLights[" + std::to_string(i) + "].position", PointLights[i]->position);
-            objectShader->setVec3("pointLights[" + std::to_string(i) + "].color", PointLights[i]->pointLightColor);
-            objectShader->setFloat("pointLights[" + std::to_string(i) + "].specularStrength", PointLights[i]->pointLightSpecStrength);
-            objectShader->setFloat("pointLights[" + std::to_string(i) + "].constant", PointLights[i]->pointLightConstant);
-            objectShader->setFloat("pointLights[" + std::to_string(i) + "].quadratic", PointLights[i]->pointLightQuadratic);
-            objectShader->setFloat("pointLights[" + std::to_string(i) + "].linear", PointLights[i]->pointLightLinear);
+        latchCamera(window, *drawing, hudFrame);
+        renderer.render(*drawing, windowWidth, windowHeight, wallFrameTime);
+        {
+            PROFILE_SCOPE("hud");
+            hudFrame.frameTime = wallFrameTime;
+            hudFrame.physicsTime = drawing->physicsTime;
+            hudFrame.physicsSteps = drawing->physicsSteps;
+            hudFrame.bodies = drawing->bodies;
+            hudFrame.awakeBodies = drawing->awakeBodies;
+            hudFrame.heapAllocations = heapAllocations() - lastAllocations; // last frame's, counted up to here
+            lastAllocations = heapAllocations();
+            hud.update(hudFrame, renderer, windowWidth, windowHeight);
+            hud.draw();
         }
-        
-        objectShader->setInt("numPointLights", PointLights.size());
-        for (Element* e : Objects) {
-            e->update(deltaTime);
-            e->draw(controlledPlayer->camera()->view(), projection, lightSource, controlledPlayer->camera()->getPos(), glfwGetTime());
-        };
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_SCOPE("glfwPollEvents");
+            glfwPollEvents();
+        }
+    }
+    snapshots.close();
+    if (simThread.joinable()) simThread.join();
+    if (inputRecorder.recording() || inputRecorder.replaying()) {
+        // the first frame had no frame before it to measure from
+        if (!frameTimes.empty()) frameTimes.erase(frameTimes.begin());
+        printPercentiles("main.cpp: frame time", frameTimes);
+        printPercentiles("main.cpp: sim time", simTimes);
     }
+    inputRecorder.close();
+    removeFromWorld(&controlledPlayer->playerElement); // the player is global and outlives Objects
     glfwDestroyWindow(window);
     glfwTerminate();
 
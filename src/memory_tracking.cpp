@@ -0,0 +1,241 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <thread>
+#include <unordered_map>
+
+#include "memory_tracking.hpp"
+
+static const char* tagNames[(int)MemoryTag::Count] = {
+    "general", "meshes", "textures", "physics", "debug", "renderer", "lighting", "shadows", "hud", "profiler"
+};
+
+const char* memoryTagName(MemoryTag tag) {
+    return tagNames[(int)tag];
+}
+
+// static initialization runs before main() on the same thread
+static const std::thread::id mainThread = std::this_thread::get_id();
+
+bool onMainThread() {
+    return std::this_thread::get_id() == mainThread;
+}
+
+size_t textureBytes(int width, int height, int layers, int bytesPerTexel, bool mipmapped) {
+    size_t bytes = (size_t)width * height * layers * bytesPerTexel;
+    return mipmapped ? bytes * 4 / 3 : bytes; // the whole mip chain adds about a third
+}
+
+#ifdef NGENFESH_PROFILE
+
+// gpu objects, keyed by kind and id since buffer 3 and texture 3 are different things.
+// never freed on purpose, the leak report runs after static destructors could have gotten to it
+struct GpuObject {
+    MemoryTag tag;
+    size_t bytes;
+};
+static std::unordered_map<uint64_t, GpuObject>& gpuObjects() {
+    static std::unordered_map<uint64_t, GpuObject>* objects = new std::unordered_map<uint64_t, GpuObject>();
+    return *objects;
+}
+static uint64_t gpuKey(GpuObjectKind kind, unsigned int id) {
+    return ((uint64_t)kind << 32) | id;
+}
+static const char* gpuKindName(uint64_t key) {
+    switch ((GpuObjectKind)(key >> 32)) {
+        case GpuObjectKind::Buffer: return "buffer";
+        case GpuObjectKind::Texture: return "texture";
+        default: return "renderbuffer";
+    }
+}
+
+struct TagCounters {
+    std::atomic<int64_t> heapBytes{0}, heapPeak{0}, heapAllocations{0};
+    int64_t gpuBytes = 0, gpuObjects = 0; // main thread only
+};
+static TagCounters counters[(int)MemoryTag::Count];
+static int64_t checkpointBytes[(int)MemoryTag::Count] = {};
+static std::atomic<uint64_t> allocationCount{0};
+static thread_local MemoryTag currentTag = MemoryTag::General;
+
+MemoryScope::MemoryScope(MemoryTag tag) {
+    previous = currentTag;
+    currentTag = tag;
+}
+
+MemoryScope::~MemoryScope() {
+    currentTag = previous;
+}
+
+uint64_t heapAllocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// sits right in front of every pointer we hand out, so delete knows the size and who to charge
+struct AllocationHeader {
+    uint64_t bytes;
+    uint32_t offset; // from the start of the real allocation to the pointer we handed out
+    uint8_t tag;
+    uint8_t padding[3];
+};
+static_assert(sizeof(AllocationHeader) == 16, "the header has to keep 16 byte alignment");
+
+static void* trackedAllocate(size_t bytes, size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t offset = std::max(alignment, sizeof(AllocationHeader));
+    void* base;
+    if (alignment <= alignof(std::max_align_t)) {
+        base = malloc(offset + bytes);
+    } else {
+        // aligned_alloc wants the size to be a multiple of the alignment
+        base = aligned_alloc(alignment, (offset + bytes + alignment - 1) / alignment * alignment);
+    }
+    if (!base) throw std::bad_alloc();
+
+    unsigned char* p = (unsigned char*)base + offset;
+    AllocationHeader* header = (AllocationHeader*)p - 1;
+    header->bytes = bytes;
+    header->offset = offset;
+    header->tag = (uint8_t)currentTag;
+
+    TagCounters& tag = counters[header->tag];
+    int64_t now = tag.heapBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    tag.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    int64_t peak = tag.heapPeak.load(std::memory_order_relaxed);
+    while (now > peak && !tag.heapPeak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    return p;
+}
+
+static void trackedFree(void* p) {
+    if (!p) return;
+    AllocationHeader* header = (AllocationHeader*)p - 1;
+    TagCounters& tag = counters[header->tag];
+    tag.heapBytes.fetch_sub(header->bytes, std::memory_order_relaxed);
+    tag.heapAllocations.fetch_sub(1, std::memory_order_relaxed);
+    free((unsigned char*)p - header->offset);
+}
+
+// every other form of new/delete (arrays, nothrow, sized) ends up in one of these by default
+void* operator new(size_t bytes) {
+    return trackedAllocate(bytes, alignof(std::max_align_t));
+}
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return trackedAllocate(bytes, (size_t)alignment);
+}
+void operator delete(void* p) noexcept {
+    trackedFree(p);
+}
+void operator delete(void* p, size_t) noexcept {
+    trackedFree(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    trackedFree(p);
+}
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    trackedFree(p);
+}
+
+MemoryTagStats memoryStats(MemoryTag tag) {
+    const TagCounters& counter = counters[(int)tag];
+    MemoryTagStats stats;
+    stats.heapBytes = counter.heapBytes.load(std::memory_order_relaxed);
+    stats.heapPeak = counter.heapPeak.load(std::memory_order_relaxed);
+    stats.heapAllocations = counter.heapAllocations.load(std::memory_order_relaxed);
+    stats.gpuBytes = counter.gpuBytes;
+    stats.gpuObjects = counter.gpuObjects;
+    return stats;
+}
+
+void trackGpuObject(GpuObjectKind kind, unsigned int id, size_t bytes, MemoryTag tag) {
+    assert(onMainThread());
+    MEMORY_TAG(MemoryTag::General); // the bookkeeping itself shouldn't land on whoever called us
+    // replace in place if it's already there, a buffer that grows mid game shouldn't cost a new hash node
+    auto it = gpuObjects().find(gpuKey(kind, id));
+    if (it != gpuObjects().end()) {
+        counters[(int)it->second.tag].gpuBytes -= it->second.bytes;
+        counters[(int)it->second.tag].gpuObjects--;
+        it->second = GpuObject{tag, bytes};
+    } else {
+        gpuObjects()[gpuKey(kind, id)] = GpuObject{tag, bytes};
+    }
+    counters[(int)tag].gpuBytes += bytes;
+    counters[(int)tag].gpuObjects++;
+}
+
+void untrackGpuObject(GpuObjectKind kind, unsigned int id) {
+    assert(onMainThread());
+    auto it = gpuObjects().find(gpuKey(kind, id));
+    if (it == gpuObjects().end()) return;
+    counters[(int)it->second.tag].gpuBytes -= it->second.bytes;
+    counters[(int)it->second.tag].gpuObjects--;
+    gpuObjects().erase(it);
+}
+
+void memoryCheckpoint() {
+    for (int i = 0; i < (int)MemoryTag::Count; i++)
+        checkpointBytes[i] = counters[i].heapBytes.load(std::memory_order_relaxed);
+}
+
+void printLeakReport() {
+    bool clean = true;
+    for (int i = 0; i < (int)MemoryTag::Count; i++) {
+        if (i == (int)MemoryTag::Profiler) continue; // thread buffers are never freed on purpose
+        int64_t leaked = counters[i].heapBytes.load(std::memory_order_relaxed) - checkpointBytes[i];
+        if (leaked <= 0) continue;
+        if (clean) printf("memory_tracking.cpp: leak report, still alive at shutdown:\n");
+        clean = false;
+        printf("    %-12s %10lld bytes of heap\n", tagNames[i], (long long)leaked);
+    }
+    int listed = 0;
+    for (const auto& [key, object] : gpuObjects()) {
+        if (clean) printf("memory_tracking.cpp: leak report, still alive at shutdown:\n");
+        clean = false;
+        if (listed++ < 16)
+            printf("    %-12s %10zu bytes in %s %u, never deleted\n", tagNames[(int)object.tag], object.bytes, gpuKindName(key), (unsigned int)key);
+    }
+    if (listed > 16) printf("    ...and %i more GL objects\n", listed - 16);
+    if (clean) printf("memory_tracking.cpp: no leaks\n");
+}
+
+#else
+
+uint64_t heapAllocations() { return 0; }
+MemoryTagStats memoryStats(MemoryTag tag) { return MemoryTagStats(); }
+void trackGpuObject(GpuObjectKind kind, unsigned int id, size_t bytes, MemoryTag tag) {}
+void untrackGpuObject(GpuObjectKind kind, unsigned int id) {}
+void memoryCheckpoint() {}
+void printLeakReport() {}
+
+#endif
+
+MemoryTagStats memoryTotals() {
+    MemoryTagStats total;
+    for (int i = 0; i < (int)MemoryTag::Count; i++) {
+        MemoryTagStats stats = memoryStats((MemoryTag)i);
+        total.heapBytes += stats.heapBytes;
+        total.heapAllocations += stats.heapAllocations;
+        total.gpuBytes += stats.gpuBytes;
+        total.gpuObjects += stats.gpuObjects;
+    }
+    return total;
+}
+
+void printMemoryReport(FILE* file) {
+#ifdef NGENFESH_PROFILE
+    fprintf(file, "%-12s %12s %12s %10s %12s %8s\n", "tag", "heap KB", "peak KB", "allocs", "gpu KB", "objects");
+    for (int i = 0; i < (int)MemoryTag::Count; i++) {
+        MemoryTagStats stats = memoryStats((MemoryTag)i);
+        fprintf(file, "%-12s %12.1f %12.1f %10lld %12.1f %8lld\n", tagNames[i], stats.heapBytes / 1024.0, stats.heapPeak / 1024.0,
+            (long long)stats.heapAllocations, stats.gpuBytes / 1024.0, (long long)stats.gpuObjects);
+    }
+    MemoryTagStats total = memoryTotals();
+    fprintf(file, "%-12s %12.1f %12s %10lld %12.1f %8lld\n", "total", total.heapBytes / 1024.0, "",
+        (long long)total.heapAllocations, total.gpuBytes / 1024.0, (long long)total.gpuObjects);
+#else
+    fprintf(file, "memory_tracking.cpp: memory tracking is only compiled into non release builds\n");
+#endif
+}
@@ -5,6 +5,12 @@
 #include "element.hpp"
 #include "player.hpp"
 #include "premade_elements.hpp"
+#include "renderer.hpp"
+#include "profiler.hpp"
+#include "hud.hpp"
+#include "memory_tracking.hpp"
+#include "systems.hpp"
+#include "scene_graph.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -40,6 +46,10 @@ void Player::init(std::vector<Element*>& Objects, Camera* cam) {
         return;
     }
     addToWorld(&playerElement, *WorldObjects);
+    // what we pick up hangs off a point in front of the camera
+    viewNode = sceneGraph.create();
+    holdNode = sceneGraph.create(viewNode);
+    sceneGraph.setLocal(holdNode, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f)));
 };
 
 void Player::update() {
@@ -51,20 +61,13 @@ void Player::update() {
     orient(attachedCamera->getYaw(), attachedCamera->getPitch());
 
     playerState.moveState = (playerElement.grounded) ? 'g' : 'a';
-    if (playerState.holdingSomething) { // if holding object, hold it
-        // playerState.heldElement->position = getCameraPos() + getCameraOrientation() * 3.0f;
-        glm::vec3 pos1 = (getCameraPos() + getCameraOrientation() * 3.0f);
-        if (playerState.heldElement->position == pos1) playerState.heldElement->velocity = glm::vec3{0.0f};
-        glm::vec3 vecTo = pos1 - playerState.heldElement->position;
-        playerState.heldElement->velocity = vecTo * 10.0f;
-        playerState.heldElement->gravity = false;
-    }
+    heldElement(); // lets go if it got removed, while holding it the scene graph carries it around
     // printf("player is %s\n", (playerState.moveState == 'g') ? "grounded" : "in air");
     // printf("velocity: %f %f %f\n", getVelocityX(), getVelocityY(), getVelocityZ());
     // printf("total speed: %f\n----\n", glm::sqrt(getVelocityX()*getVelocityX() + getVelocityY()*getVelocityY() + getVelocityZ()*getVelocityZ()));
 }
 
-void Player::keyInput(float deltaTime, KeyState keys[512], GLFWwindow* window) {
+void Player::keyInput(float deltaTime, const ActionState& actions) {
     glm::vec3 right = glm::normalize(glm::cross(camera()->getOrientation(),camera()->getUp()));
     glm::vec3 forward = camera()->getOrientation();
     forward.y = 0.0f; // comment this out to disable FPS movement
@@ -72,20 +75,14 @@ void Player::keyInput(float deltaTime, KeyState keys[512], GLFWwindow* window) {
         forward = glm::normalize(forward);
     glm::vec3 moveDir = glm::vec3(0.0f);
     
-    if (keys[GLFW_KEY_W].currentState)
+    if (actions.down(Action::MoveForward))
         moveDir += forward;
-    if (keys[GLFW_KEY_S].currentState)
+    if (actions.down(Action::MoveBack))
         moveDir -= forward;
-    if (keys[GLFW_KEY_A].currentState)
+    if (actions.down(Action::MoveLeft))
         moveDir -= right;
-    if (keys[GLFW_KEY_D].currentState)
+    if (actions.down(Action::MoveRight))
         moveDir += right;
-    if (keys[GLFW_KEY_ESCAPE].currentState && !keys[GLFW_KEY_ESCAPE].pastState) {
-        if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_NORMAL)
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-        else
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-    }
     if (glm::length(moveDir) > 0.0f)
         moveDir = glm::normalize(moveDir);
 
@@ -93,27 +90,52 @@ void Player::keyInput(float deltaTime, KeyState keys[512], GLFWwindow* window) {
     // playerElement.velocity.y = moveDir.y * playerState.speed;
     playerElement.velocity.z = moveDir.z * playerState.speed;
     
-    if (keys[GLFW_KEY_SPACE].currentState && getMoveState() == 'g') playerElement.velocity.y += playerState.jumpPower;
+    if (actions.down(Action::Jump) && getMoveState() == 'g') playerElement.velocity.y += playerState.jumpPower;
 
-    if (keys[GLFW_KEY_E].currentState && !keys[GLFW_KEY_E].pastState) attemptPickupElement();
-    if (keys[GLFW_KEY_F].currentState && !keys[GLFW_KEY_F].pastState) attemptRocketElement();
-    if (keys[GLFW_KEY_H].currentState)
+    if (actions.justPressed(Action::Pickup)) attemptPickupElement();
+    if (actions.justPressed(Action::Rocket)) attemptRocketElement();
+    if (actions.down(Action::RotateX))
         attemptOrientElement(glm::vec3(0.01f,0.0f,0.0f));
-    if (keys[GLFW_KEY_J].currentState)
+    if (actions.down(Action::RotateY))
         attemptOrientElement(glm::vec3(0.0f,0.01f,0.0f));
-    if (keys[GLFW_KEY_K].currentState)
+    if (actions.down(Action::RotateZ))
         attemptOrientElement(glm::vec3(0.0f,0.0f,0.01f));
     
-    if (keys[GLFW_KEY_P].currentState && !keys[GLFW_KEY_P].pastState)
+    if (actions.justPressed(Action::ToggleDebug))
         renderDebug = !renderDebug;
+    if (actions.justPressed(Action::ToggleDeferred))
+        renderDeferred = !renderDeferred;
+    if (actions.justPressed(Action::TogglePrepass))
+        renderDepthPrepass = !renderDepthPrepass;
+    if (actions.justPressed(Action::DumpTrace))
+        PROFILE_DUMP("trace.json");
+    if (actions.justPressed(Action::TogglePerfHud))
+        showPerfHud = !showPerfHud;
+    if (actions.justPressed(Action::MemoryReport))
+        printMemoryReport();
+}
+
+void Player::updateCamera() {
+    attachedCamera->setPos(playerElement.renderPosition() + attachedCamera->getOffset());
+    sceneGraph.setLocal(viewNode, glm::inverse(attachedCamera->view())); // camera space to world, -z is forward
+}
+
+Element* Player::heldElement() {
+    if (!playerState.holdingSomething) return nullptr;
+    Element* held = elementFor(world, playerState.heldEntity);
+    if (!held) { // removed while we had it, removeFromWorld let go of it on the graph's side
+        playerState.holdingSomething = false;
+        playerState.heldEntity = NO_ENTITY;
+    }
+    return held;
 }
 
 void Player::attemptPickupElement() {
-        if (playerState.holdingSomething) {
+        if (Element* held = heldElement()) {
             playerState.holdingSomething = false;
-            playerState.heldElement->gravity = true;
-            playerState.heldElement->velocity = glm::vec3{0.0f};
-            playerState.heldElement = nullptr;
+            detachElement(held);
+            held->velocity = glm::vec3{0.0f};
+            playerState.heldEntity = NO_ENTITY;
             return;
         }
 
@@ -122,7 +144,10 @@ void Player::attemptPickupElement() {
             if (!pickupHit.hitElement->holdable) return;
             if (pickupHit.hitElement->debug) return;
             playerState.holdingSomething = true;
-            playerState.heldElement = pickupHit.hitElement;
+            playerState.heldEntity = pickupHit.hitElement->entity;
+            // snaps to the hold point but keeps facing the way it did, from here on it turns with the camera
+            glm::mat3 holdBasis(sceneGraph.world(holdNode));
+            attachElement(pickupHit.hitElement, holdNode, glm::mat4(glm::transpose(holdBasis) * pickupHit.hitElement->sceneBasis));
         }
 }
 void Player::attemptOrientElement(glm::vec3 rotate) {
@@ -132,11 +157,11 @@ void Player::attemptOrientElement(glm::vec3 rotate) {
             // if (pickupHit.hitElement->debug) return;
             // playerState.holdingSomething = true;
             // playerState.heldElement = pickupHit.hitElement;
-            pickupHit.hitElement->rotation += rotate;
+            pickupHit.hitElement->rotateBy(rotate);
         }
 }
 void Player::attemptRocketElement() {
-        if (playerState.holdingSomething) {
+        if (heldElement()) {
             // playerState.holdingSomething = false;
             // playerState.heldElement->gravity = true;
             // playerState.heldElement = nullptr;
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <stdio.h>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "prefab.hpp"
+#include "systems.hpp"
+#include "util.hpp"
+#include "scene_graph.hpp"
+#include "profiler.hpp"
+
+void Prefab::init(size_t capacity, std::vector<Element*>& Objects) {
+    if (!instances.empty()) {
+        printf("prefab.cpp: init() called twice\n");
+        return;
+    }
+    if (base.emitPointLight) {
+        printf("prefab.cpp: point lights don't get pooled, instances won't light anything\n");
+        base.emitPointLight = false;
+    }
+    if (!base.vertices.empty()) base.init();
+    else { // physics only, the bounding box is the shape
+        base.localBoundsMin = base.bounding_box_corner1;
+        base.localBoundsMax = base.bounding_box_corner2;
+    }
+
+    // copies now so spawning doesn't have to
+    instances.resize(capacity);
+    freeInstances.resize(capacity);
+    for (size_t i = 0; i < capacity; i++) {
+        instances[i] = base;
+        instances[i].sharedMesh = true;
+        freeInstances[i] = capacity - 1 - i; // so the first spawn gets instance 0
+    }
+    // an instance spawned turned or spinning lands in another archetype than the base, room in every one
+    // of them so no SpawnTransform makes spawn allocate. the same mask twice only gets reserved once
+    ComponentMask masks[4];
+    int maskCount = 0;
+    for (int turned = 0; turned < 2; turned++) {
+        for (int spinning = 0; spinning < 2; spinning++) {
+            ComponentMask mask = elementMask(base, turned, spinning);
+            if (std::find(masks, masks + maskCount, mask) == masks + maskCount) masks[maskCount++] = mask;
+        }
+    }
+    for (int i = 0; i < maskCount; i++) world.reserve(masks[i], capacity);
+    Objects.reserve(Objects.size() + capacity); // spawn push_backs into it
+}
+
+size_t spawn(Prefab& prefab, size_t count, const SpawnTransform* transforms, std::vector<Element*>& Objects, Entity* spawned) {
+    PROFILE_SCOPE("spawn");
+    const Element& base = prefab.base;
+    size_t n = std::min(count, prefab.freeInstances.size());
+    for (size_t i = 0; i < n; i++) {
+        Element& e = prefab.instances[prefab.freeInstances.back()];
+        prefab.freeInstances.pop_back();
+        // put back whatever the last life changed. removeFromWorld detached it already, this is in case
+        // something attached it while it was dead
+        detachElement(&e);
+        e.sceneBasis = base.sceneBasis;
+        if (e.sceneNode != NO_SCENE_NODE) sceneGraph.setParent(e.sceneNode, NO_SCENE_NODE);
+        e.position = transforms[i].position;
+        e.velocity = transforms[i].velocity;
+        e.orientation = e.previousOrientation = e.renderOrientation = transforms[i].orientation;
+        e.angularVelocity = transforms[i].angularVelocity;
+        e.lastPosition = base.lastPosition;
+        e.holdVelocity = glm::vec3(0.0f);
+        e.gravity = base.gravity;
+        e.grounded = false;
+        if (e.orientation == base.orientation) {
+            e.bounding_box_corner1 = base.bounding_box_corner1;
+            e.bounding_box_corner2 = base.bounding_box_corner2;
+        } else {
+            e.fitBounds();
+        }
+        addToWorld(&e, Objects);
+        if (spawned) spawned[i] = e.entity;
+    }
+    if (n < count) printf("prefab.cpp: pool of %zu ran out, %zu not spawned\n", prefab.capacity(), count - n);
+    return n;
+}
+
+bool despawn(Prefab& prefab, Entity entity) {
+    Element* e = elementFor(world, entity);
+    if (!e || e < prefab.instances.data() || e >= prefab.instances.data() + prefab.instances.size()) return false;
+    removeFromWorld(e);
+    prefab.freeInstances.push_back(e - prefab.instances.data());
+    return true;
+}
+
+void despawnAll(Prefab& prefab) {
+    for (Element& e : prefab.instances) {
+        if (!e.objects) continue;
+        removeFromWorld(&e);
+        prefab.freeInstances.push_back(&e - prefab.instances.data());
+    }
+}
@@ -0,0 +1,99 @@
+#include "profiler.hpp"
+
+#ifdef NGENFESH_PROFILE
+
+#include <iostream>
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "memory_tracking.hpp"
+
+namespace profiler {
+    static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // every thread that ever recorded a zone, the lock is only taken the first time a thread records something
+    static std::mutex buffersMutex;
+    static std::vector<ThreadBuffer*> buffers;
+
+    uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+
+    ThreadBuffer& threadBuffer() {
+        // never freed, so a thread that already finished still shows up in the trace
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            MEMORY_TAG(MemoryTag::Profiler);
+            buffer = new ThreadBuffer();
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            buffer->threadId = buffers.size() + 1;
+            buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void setThreadName(const char* name) {
+        threadBuffer().threadName = name;
+    }
+
+    ThreadBuffer& timelineBuffer(const char* name) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (ThreadBuffer* buffer : buffers) {
+            if (buffer->timeline && buffer->threadName == name) return *buffer;
+        }
+        MEMORY_TAG(MemoryTag::Profiler);
+        ThreadBuffer* buffer = new ThreadBuffer();
+        buffer->threadName = name;
+        buffer->threadId = buffers.size() + 1;
+        buffer->timeline = true;
+        buffers.push_back(buffer);
+        return *buffer;
+    }
+
+    static void writeEscaped(FILE* file, const char* text) {
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') fputc('\\', file);
+            fputc(*c, file);
+        }
+    }
+
+    bool writeTrace(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            std::cout << "profiler.cpp: couldn't open " << path << " for writing\n";
+            return false;
+        }
+        size_t written = 0;
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (ThreadBuffer* buffer : buffers) {
+            if (buffer->threadName) {
+                fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->threadId);
+                writeEscaped(file, buffer->threadName);
+                fprintf(file, "\"}}");
+                first = false;
+            }
+            // other threads keep recording while we read, the oldest zones of a busy thread might get overwritten under us
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t count = head < PROFILE_RING_SIZE ? head : PROFILE_RING_SIZE;
+            for (uint64_t i = head - count; i < head; i++) {
+                const Zone& zone = buffer->zones[i % PROFILE_RING_SIZE];
+                fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+                writeEscaped(file, zone.name);
+                // chrome wants microseconds
+                fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}", buffer->threadId, zone.start / 1000.0, (zone.end - zone.start) / 1000.0);
+                first = false;
+                written++;
+            }
+        }
+        fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        fclose(file);
+        std::cout << "profiler.cpp: wrote " << written << " zones to " << path << "\n";
+        return true;
+    }
+}
+
+#endif
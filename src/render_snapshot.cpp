@@ -0,0 +1,110 @@
+#include <iostream>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "render_snapshot.hpp"
+#include "profiler.hpp"
+
+void captureSnapshot(RenderSnapshot& snapshot, const std::vector<Element*>& Objects, const std::vector<Element*>& lights, const Camera& camera) {
+    PROFILE_FUNCTION();
+    snapshot.states.resize(Objects.size());
+    snapshot.bodies = snapshot.awakeBodies = 0;
+    for (size_t i = 0; i < Objects.size(); i++) {
+        const Element* e = Objects[i];
+        ElementDrawState& state = snapshot.states[i];
+        state.element = e;
+        state.matrix = e->getMatrix();
+        state.position = e->renderPosition();
+        state.min = state.position + e->bounding_box_corner1;
+        state.max = state.position + e->bounding_box_corner2;
+        state.VAO = e->VAO;
+        state.EBO = e->EBO;
+        state.depthVAO = e->depthVAO;
+        state.indexCount = e->indexCount;
+        state.drawMode = e->draw_mode;
+        state.shader = e->shader;
+        state.useTexture = e->getUseTexture();
+        state.texture = e->texture.texture;
+        state.textureTarget = e->texture.target;
+        state.wireframe = e->wireframe;
+        state.debug = e->debug;
+        state.hasCollision = e->hasCollision;
+        state.isPlayer = e->isPlayer;
+        state.castShadow = e->castShadow;
+        state.pointLightColor = e->pointLightColor;
+        state.pointLightConstant = e->pointLightConstant;
+        state.pointLightLinear = e->pointLightLinear;
+        state.pointLightQuadratic = e->pointLightQuadratic;
+        state.pointLightSpecStrength = e->pointLightSpecStrength;
+        state.pointLightShadows = e->pointLightShadows;
+        state.shadowSlot = -1;
+        if (e->anchored || e->debug || !e->hasCollision) continue;
+        snapshot.bodies++;
+        if (e->velocity != glm::vec3(0.0f)) snapshot.awakeBodies++;
+    }
+    snapshot.lights.clear();
+    for (const Element* light : lights) {
+        if (light->objects != &Objects) continue; // not in the world, nothing to light with
+        snapshot.lights.push_back(&snapshot.states[light->objectIndex]);
+    }
+    snapshot.camera = camera;
+}
+
+void ElementDrawState::draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, Shader* shaderOverride) const {
+    PROFILE_SCOPE("ElementDrawState::draw");
+    if (!renderDebug && debug) return;
+    Shader* shader = shaderOverride ? shaderOverride : this->shader;
+    if (!shader) return;
+
+    shader->use();
+    shader->setMat4("view", view);
+    shader->setMat4("projection", projection);
+    shader->setMat4("model", matrix);
+    shader->setInt("useTexture", useTexture);
+    shader->setVec3("viewPos", cameraPos);
+    if (wireframe || debug)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    if (useTexture)
+        glBindTexture(textureTarget, texture);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glDrawElements(drawMode, indexCount, GL_UNSIGNED_INT, 0);
+    if (wireframe || debug)
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    if (useTexture)
+        glBindTexture(textureTarget, 0);
+}
+
+void ElementDrawState::drawDepth(Shader& depthShader) const {
+    if (!depthVAO) return;
+    depthShader.setMat4("model", matrix);
+    glBindVertexArray(depthVAO);
+    glDrawElements(drawMode, indexCount, GL_UNSIGNED_INT, 0);
+}
+
+bool SnapshotBuffer::publish() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closed) return false;
+    std::swap(writeIndex, readyIndex);
+    fresh = true;
+    changed.notify_all();
+    changed.wait(lock, [&]() { return !fresh || closed; });
+    return !closed;
+}
+
+RenderSnapshot* SnapshotBuffer::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return fresh || closed; });
+    if (!fresh) return nullptr;
+    std::swap(readIndex, readyIndex);
+    fresh = false;
+    changed.notify_all();
+    return &buffers[readIndex];
+}
+
+void SnapshotBuffer::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    changed.notify_all();
+}
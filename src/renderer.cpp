@@ -0,0 +1,331 @@
+#include <iostream>
+#include <algorithm>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "renderer.hpp"
+#include "shader_def.hpp"
+#include "profiler.hpp"
+#include "memory_tracking.hpp"
+#include "debug_draw.hpp"
+
+std::atomic<bool> renderDeferred{false};
+std::atomic<bool> renderDepthPrepass{false};
+
+void GBuffer::init(int aWidth, int aHeight) {
+    MEMORY_TAG(MemoryTag::Renderer);
+    release();
+    width = aWidth;
+    height = aHeight;
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+    glGenTextures(1, &normalTexture);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16_SNORM, width, height, 0, GL_RG, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, normalTexture, 0);
+
+    glGenTextures(1, &albedoTexture);
+    glBindTexture(GL_TEXTURE_2D, albedoTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, albedoTexture, 0);
+
+    // same format as the window's depth buffer so it can be blitted over for the forward drawn stuff
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    // all three are 4 bytes a pixel
+    trackGpuObject(GpuObjectKind::Texture, normalTexture, textureBytes(width, height, 1, 4, false), MemoryTag::Renderer);
+    trackGpuObject(GpuObjectKind::Texture, albedoTexture, textureBytes(width, height, 1, 4, false), MemoryTag::Renderer);
+    trackGpuObject(GpuObjectKind::Texture, depthTexture, textureBytes(width, height, 1, 4, false), MemoryTag::Renderer);
+
+    unsigned int attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "renderer.cpp: G-buffer framebuffer is not complete!\n";
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::bindTextures() const {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, normalTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, albedoTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void GBuffer::release() {
+    untrackGpuObject(GpuObjectKind::Texture, normalTexture);
+    untrackGpuObject(GpuObjectKind::Texture, albedoTexture);
+    untrackGpuObject(GpuObjectKind::Texture, depthTexture);
+    if (FBO) glDeleteFramebuffers(1, &FBO);
+    if (normalTexture) glDeleteTextures(1, &normalTexture);
+    if (albedoTexture) glDeleteTextures(1, &albedoTexture);
+    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    FBO = normalTexture = albedoTexture = depthTexture = 0;
+}
+
+GBuffer::~GBuffer() {
+    release();
+}
+
+void Renderer::init(int width, int height) {
+    MEMORY_TAG(MemoryTag::Renderer);
+    lightClusters.init();
+    shadows.init();
+    gbuffer.init(width, height);
+    gpuTimers.init();
+    debugDraw.init();
+    glGenVertexArrays(1, &emptyVAO);
+    glGenQueries(SAMPLE_QUERY_COUNT, sampleQueries);
+    lastDeferred = renderDeferred;
+    lastDepthPrepass = renderDepthPrepass;
+}
+
+Renderer::~Renderer() {
+    debugDraw.release();
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteQueries(SAMPLE_QUERY_COUNT, sampleQueries);
+}
+
+void Renderer::render(const RenderSnapshot& snapshot, int width, int height, float deltaTime) {
+    PROFILE_FUNCTION();
+    MEMORY_TAG(MemoryTag::Renderer);
+    const std::vector<ElementDrawState>& states = snapshot.states;
+    const Camera& camera = snapshot.camera;
+    if (renderDeferred != lastDeferred || renderDepthPrepass != lastDepthPrepass) {
+        if (modeFrames > 0)
+            printf("renderer.cpp: %s%s averaged %.3f ms (%.3f ms gpu), %.2f shaded samples per pixel over %i frames\n", lastDeferred ? "deferred" : "forward", lastDepthPrepass ? " + pre-pass" : "",
+                modeFrameTime / modeFrames * 1000.0f, modeGpuTime / modeFrames, modeOverdraw / modeFrames, modeFrames);
+        printf("renderer.cpp: switched to %s%s\n", renderDeferred ? "deferred" : "forward", renderDepthPrepass ? " + pre-pass" : "");
+        lastDeferred = renderDeferred;
+        lastDepthPrepass = renderDepthPrepass;
+        modeFrameTime = 0.0f;
+        modeOverdraw = 0.0f;
+        modeGpuTime = 0.0f;
+        modeFrames = 0;
+    }
+    stats.drawCalls = 0;
+    stats.depthDrawCalls = 0;
+    stats.triangles = 0;
+    stats.stateChanges = 0;
+    lastProgram = lastTexture = lastVAO = 0;
+    readSampleQuery(width, height);
+    gpuTimers.beginFrame();
+    int frameZone = gpuTimers.begin("frame");
+    modeFrameTime += deltaTime;
+    modeOverdraw += stats.overdraw;
+    modeGpuTime += gpuTimers.frameMilliseconds;
+    modeFrames++;
+
+    glm::mat4 view = camera.view();
+    glm::mat4 projection = glm::perspective(glm::radians(fov), (float)width / (float)height, zNear, zFar);
+    // before the lights get packed, this hands out the shadow slots they carry to the shader
+    {
+        PROFILE_SCOPE("shadows");
+        int zone = gpuTimers.begin("shadows");
+        shadows.update(states, snapshot.lights, sun, view, fov, (float)width / (float)height, zNear, zFar, camera.getPos());
+        gpuTimers.end(zone);
+    }
+    glViewport(0, 0, width, height);
+    {
+        PROFILE_SCOPE("light clusters");
+        int zone = gpuTimers.begin("light clusters");
+        lightClusters.update(snapshot.lights, view, projection, zNear, zFar);
+        gpuTimers.end(zone);
+    }
+    buildDrawLists(states, camera.getPos());
+    if (renderDebug) {
+        for (const ElementDrawState& e : states) {
+            if (!e.hasCollision || e.debug || e.isPlayer) continue; // the player's box would be around the camera
+            debugDraw.box(e.min, e.max, glm::vec3(1.0f, 0.0f, 0.0f));
+        }
+    }
+
+    if (renderDeferred)
+        deferredPass(states, view, projection, camera.getPos(), width, height);
+    else
+        forwardPass(states, view, projection, camera.getPos(), width, height);
+    gpuTimers.end(frameZone);
+    sampleQueryFrame++;
+}
+
+void Renderer::buildDrawLists(const std::vector<ElementDrawState>& states, glm::vec3 cameraPos) {
+    PROFILE_FUNCTION();
+    sortKeys.clear();
+    unlit.clear();
+    // from the snapshot, not the world, which belongs to the simulation (and might be a frame ahead)
+    for (const ElementDrawState& e : states) {
+        if (!e.VAO) continue; // never init()'d
+        if (e.shader == objectShader && !e.debug) {
+            glm::vec3 toCamera = (e.min + e.max) * 0.5f - cameraPos;
+            sortKeys.push_back({glm::dot(toCamera, toCamera), &e});
+        } else {
+            unlit.push_back(&e);
+        }
+    }
+    // front to back, so the closest stuff fills the depth buffer first and everything behind it fails early
+    std::sort(sortKeys.begin(), sortKeys.end(), [](const std::pair<float, const ElementDrawState*>& a, const std::pair<float, const ElementDrawState*>& b) {
+        return a.first < b.first;
+    });
+    opaque.clear();
+    for (const std::pair<float, const ElementDrawState*>& key : sortKeys)
+        opaque.push_back(key.second);
+}
+
+void Renderer::opaquePass(const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, Shader* shaderOverride) {
+    PROFILE_FUNCTION();
+    if (renderDepthPrepass) {
+        PROFILE_SCOPE("depth pre-pass");
+        int zone = gpuTimers.begin("depth pre-pass");
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        depthShader->use();
+        depthShader->setMat4("view", view);
+        depthShader->setMat4("projection", projection);
+        for (const ElementDrawState* e : opaque) {
+            e->drawDepth(*depthShader);
+            stats.depthDrawCalls++;
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        // depth is final now, only the visible fragment of every pixel passes
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        gpuTimers.end(zone);
+    }
+
+    int zone = gpuTimers.begin(shaderOverride == gbufferShader ? "gbuffer" : "opaque");
+    glBeginQuery(GL_SAMPLES_PASSED, sampleQueries[sampleQueryFrame % SAMPLE_QUERY_COUNT]);
+    for (const ElementDrawState* e : opaque) {
+        int drawZone = timeEachDraw ? gpuTimers.begin("opaque draw") : -1;
+        countStateChanges(e, shaderOverride ? shaderOverride : e->shader);
+        e->draw(view, projection, cameraPos, shaderOverride);
+        gpuTimers.end(drawZone);
+        stats.drawCalls++;
+        stats.triangles += e->indexCount / 3;
+    }
+    glEndQuery(GL_SAMPLES_PASSED);
+    gpuTimers.end(zone);
+
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+}
+
+void Renderer::countStateChanges(const ElementDrawState* e, const Shader* shader) {
+    unsigned int program = shader ? shader->ID : 0;
+    unsigned int texture = e->useTexture ? e->texture : 0;
+    if (program != lastProgram) stats.stateChanges++;
+    if (texture != lastTexture) stats.stateChanges++;
+    if (e->VAO != lastVAO) stats.stateChanges++;
+    lastProgram = program;
+    lastTexture = texture;
+    lastVAO = e->VAO;
+}
+
+void Renderer::readSampleQuery(int width, int height) {
+    if (sampleQueryFrame < SAMPLE_QUERY_COUNT) return; // nothing issued that long ago yet
+    // the slot we're about to reuse is the oldest query
+    unsigned int query = sampleQueries[sampleQueryFrame % SAMPLE_QUERY_COUNT];
+    int available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return; // keep last frame's numbers rather than stall
+    GLuint64 samples = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+    stats.shadedSamples = samples;
+    stats.overdraw = (float)samples / (float)(width * height);
+}
+
+void Renderer::forwardPass(const std::vector<ElementDrawState>& states, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, int width, int height) {
+    PROFILE_FUNCTION();
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    glClearColor(0.0f,0.0f,0.0f,1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    lightClusters.bind(*objectShader, width, height);
+    shadows.bind(*objectShader, sun);
+    opaquePass(view, projection, cameraPos, nullptr);
+    if (skybox.loaded()) {
+        int zone = gpuTimers.begin("sky");
+        skybox.draw(view, projection);
+        gpuTimers.end(zone);
+        stats.drawCalls++;
+    }
+    int zone = gpuTimers.begin("unlit");
+    for (const ElementDrawState* e : unlit) {
+        countStateChanges(e, e->shader);
+        e->draw(view, projection, cameraPos);
+        stats.drawCalls++;
+    }
+    gpuTimers.end(zone);
+    zone = gpuTimers.begin("debug lines");
+    stats.drawCalls += debugDraw.flush(view, projection);
+    gpuTimers.end(zone);
+}
+
+void Renderer::deferredPass(const std::vector<ElementDrawState>& states, const glm::mat4& view, const glm::mat4& projection, glm::vec3 cameraPos, int width, int height) {
+    PROFILE_FUNCTION();
+    if (width != gbuffer.width || height != gbuffer.height)
+        gbuffer.init(width, height);
+
+    // geometry pass, everything that would have been lit by objectShader goes into the G-buffer
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.FBO);
+    glClearColor(0.0f,0.0f,0.0f,1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    opaquePass(view, projection, cameraPos, gbufferShader);
+
+    // lighting pass, once per pixel
+    int lightingZone = gpuTimers.begin("lighting pass");
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_DEPTH_TEST);
+    lightClusters.bind(*deferredShader, width, height);
+    shadows.bind(*deferredShader, sun);
+    deferredShader->setInt("gNormal", 0);
+    deferredShader->setInt("gAlbedo", 1);
+    deferredShader->setInt("gDepth", 2);
+    deferredShader->setMat4("invViewProjection", glm::inverse(projection * view));
+    deferredShader->setVec3("viewPos", cameraPos);
+    gbuffer.bindTextures();
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    stats.drawCalls++;
+    glEnable(GL_DEPTH_TEST);
+    gpuTimers.end(lightingZone);
+
+    // copy depth over so the unlit stuff (debug boxes, light cubes) still gets occluded properly
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.FBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+    if (skybox.loaded()) {
+        int zone = gpuTimers.begin("sky");
+        skybox.draw(view, projection);
+        gpuTimers.end(zone);
+        stats.drawCalls++;
+    }
+    int zone = gpuTimers.begin("unlit");
+    for (const ElementDrawState* e : unlit) {
+        countStateChanges(e, e->shader);
+        e->draw(view, projection, cameraPos);
+        stats.drawCalls++;
+    }
+    gpuTimers.end(zone);
+    zone = gpuTimers.begin("debug lines");
+    stats.drawCalls += debugDraw.flush(view, projection);
+    gpuTimers.end(zone);
+}
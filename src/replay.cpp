@@ -0,0 +1,103 @@
+#include <iostream>
+#include <algorithm>
+#include <string.h>
+
+#include "replay.hpp"
+
+bool InputRecorder::startRecording(const char* path, const int* codes, int keyCount) {
+    close();
+    keyCodes.clear();
+    for (int i = 0; i < keyCount; i++) {
+        if (codes[i] != 0) keyCodes.push_back(codes[i]);
+    }
+    if (keyCodes.size() > REPLAY_MAX_KEYS) {
+        printf("replay.cpp: can only record %i keys, got %zu\n", REPLAY_MAX_KEYS, keyCodes.size());
+        return false;
+    }
+    file = fopen(path, "wb");
+    if (!file) {
+        printf("replay.cpp: couldn't open %s for recording\n", path);
+        return false;
+    }
+    replayMode = false;
+    frames = 0;
+    uint32_t version = REPLAY_VERSION, count = keyCodes.size();
+    fwrite("NGFR", 1, 4, file);
+    fwrite(&version, sizeof(version), 1, file);
+    fwrite(&count, sizeof(count), 1, file);
+    for (int code : keyCodes) {
+        int32_t code32 = code;
+        fwrite(&code32, sizeof(code32), 1, file);
+    }
+    printf("replay.cpp: recording input to %s\n", path);
+    return true;
+}
+
+bool InputRecorder::startReplay(const char* path) {
+    close();
+    file = fopen(path, "rb");
+    if (!file) {
+        printf("replay.cpp: couldn't open %s for replay\n", path);
+        return false;
+    }
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "NGFR", 4) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != REPLAY_VERSION ||
+        fread(&count, sizeof(count), 1, file) != 1 || count > REPLAY_MAX_KEYS) {
+        printf("replay.cpp: %s isn't a version %i input recording\n", path, REPLAY_VERSION);
+        close();
+        return false;
+    }
+    keyCodes.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t code32 = 0;
+        if (fread(&code32, sizeof(code32), 1, file) != 1) {
+            printf("replay.cpp: %s is cut off\n", path);
+            close();
+            return false;
+        }
+        keyCodes[i] = code32;
+    }
+    replayMode = true;
+    frames = 0;
+    printf("replay.cpp: replaying input from %s\n", path);
+    return true;
+}
+
+void InputRecorder::recordFrame(const InputFrame& frame) {
+    if (!recording()) return;
+    fwrite(&frame.deltaTime, sizeof(float), 1, file);
+    fwrite(&frame.mouseDelta.x, sizeof(float), 1, file);
+    fwrite(&frame.mouseDelta.y, sizeof(float), 1, file);
+    fwrite(&frame.keyMask, sizeof(uint64_t), 1, file);
+    frames++;
+}
+
+bool InputRecorder::nextFrame(InputFrame& frame) {
+    if (!replaying()) return false;
+    if (fread(&frame.deltaTime, sizeof(float), 1, file) != 1 ||
+        fread(&frame.mouseDelta.x, sizeof(float), 1, file) != 1 ||
+        fread(&frame.mouseDelta.y, sizeof(float), 1, file) != 1 ||
+        fread(&frame.keyMask, sizeof(uint64_t), 1, file) != 1)
+        return false;
+    frames++;
+    return true;
+}
+
+void InputRecorder::close() {
+    if (!file) return;
+    fclose(file);
+    file = nullptr;
+    if (!replayMode)
+        printf("replay.cpp: recorded %i frames\n", frames);
+}
+
+void printPercentiles(const char* label, std::vector<float>& samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](float p) {
+        return samples[std::min((size_t)(p * samples.size()), samples.size() - 1)] * 1000.0f;
+    };
+    printf("%s: p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms over %zu frames\n", label, at(0.50f), at(0.95f), at(0.99f), samples.back() * 1000.0f, samples.size());
+}
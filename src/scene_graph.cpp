@@ -0,0 +1,222 @@
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "scene_graph.hpp"
+#include "element.hpp"
+#include "util.hpp"
+#include "profiler.hpp"
+
+SceneGraph sceneGraph;
+
+SceneNodeId SceneGraph::create(SceneNodeId parent) {
+    SceneNodeId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = slots.size();
+        slots.push_back(DEAD);
+        parentOf.push_back(NO_SCENE_NODE);
+    }
+    // goes on the end for now, layout() puts it where it belongs
+    slots[id] = order.size();
+    parentOf[id] = alive(parent) ? parent : NO_SCENE_NODE;
+    order.push_back(id);
+    parentIndex.push_back(DEAD);
+    firstChild.push_back(0);
+    childCount.push_back(0);
+    locals.push_back(glm::mat4(1.0f));
+    worlds.push_back(glm::mat4(1.0f));
+    elements.push_back(nullptr);
+    dirtyFlags.push_back(0);
+    visited.push_back(0);
+    liveNodes++;
+    layoutDirty = true;
+    return id;
+}
+
+void SceneGraph::destroy(SceneNodeId node) {
+    if (!alive(node)) return;
+    for (SceneNodeId child = 0; child < parentOf.size(); child++) {
+        if (parentOf[child] != node || !alive(child)) continue;
+        locals[slots[child]] = worlds[slots[child]]; // stays where it is
+        parentOf[child] = NO_SCENE_NODE;
+    }
+    // leaves a hole, layout() closes it
+    uint32_t slot = slots[node];
+    order[slot] = DEAD;
+    elements[slot] = nullptr;
+    slots[node] = DEAD;
+    parentOf[node] = NO_SCENE_NODE;
+    freeIds.push_back(node);
+    liveNodes--;
+    layoutDirty = true;
+}
+
+void SceneGraph::setParent(SceneNodeId node, SceneNodeId parent) {
+    if (!alive(node)) return;
+    if (!alive(parent)) parent = NO_SCENE_NODE;
+    if (parentOf[node] == parent) return;
+    for (SceneNodeId up = parent; up != NO_SCENE_NODE; up = parentOf[up]) {
+        if (up == node) {
+            printf("scene_graph.cpp: can't parent a node to something under it\n");
+            return;
+        }
+    }
+    parentOf[node] = parent;
+    layoutDirty = true;
+}
+
+void SceneGraph::setLocal(SceneNodeId node, const glm::mat4& local) {
+    uint32_t slot = slots[node];
+    if (locals[slot] == local) return; // didn't move, nothing under it has to be redone
+    locals[slot] = local;
+    if (!dirtyFlags[slot]) {
+        dirtyFlags[slot] = 1;
+        dirty.push_back(node);
+    }
+}
+
+void SceneGraph::layout() {
+    PROFILE_FUNCTION();
+    // children of every id, counting sort style so there are no per node vectors
+    std::vector<uint32_t> childStart(slots.size() + 1, 0), children;
+    for (SceneNodeId id : order)
+        if (id != DEAD && parentOf[id] != NO_SCENE_NODE) childStart[parentOf[id] + 1]++;
+    for (size_t i = 1; i < childStart.size(); i++) childStart[i] += childStart[i - 1];
+    children.resize(childStart.back());
+    std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+    for (SceneNodeId id : order)
+        if (id != DEAD && parentOf[id] != NO_SCENE_NODE) children[fill[parentOf[id]]++] = id;
+
+    // breadth first from the roots, in the order they were in before so the layout doesn't shuffle for nothing
+    std::vector<SceneNodeId> newOrder;
+    newOrder.reserve(order.size());
+    for (SceneNodeId id : order)
+        if (id != DEAD && parentOf[id] == NO_SCENE_NODE) newOrder.push_back(id);
+    for (size_t i = 0; i < newOrder.size(); i++) {
+        SceneNodeId id = newOrder[i];
+        for (uint32_t c = childStart[id]; c < childStart[id + 1]; c++) newOrder.push_back(children[c]);
+    }
+
+    std::vector<glm::mat4> newLocals(newOrder.size());
+    std::vector<Element*> newElements(newOrder.size());
+    for (uint32_t i = 0; i < newOrder.size(); i++) {
+        newLocals[i] = locals[slots[newOrder[i]]];
+        newElements[i] = elements[slots[newOrder[i]]];
+    }
+    for (uint32_t i = 0; i < newOrder.size(); i++) slots[newOrder[i]] = i;
+    parentIndex.assign(newOrder.size(), DEAD);
+    firstChild.assign(newOrder.size(), 0);
+    childCount.assign(newOrder.size(), 0);
+    uint32_t next = 0; // children of node i start where those of node i-1 ended, that's what breadth first means
+    for (uint32_t i = 0; i < newOrder.size(); i++) {
+        SceneNodeId id = newOrder[i];
+        if (parentOf[id] == NO_SCENE_NODE) next++;
+        else parentIndex[i] = slots[parentOf[id]];
+        childCount[i] = childStart[id + 1] - childStart[id];
+    }
+    for (uint32_t i = 0; i < newOrder.size(); i++) {
+        firstChild[i] = next;
+        next += childCount[i];
+    }
+    order.swap(newOrder);
+    locals.swap(newLocals);
+    elements.swap(newElements);
+    worlds.resize(order.size());
+    dirtyFlags.assign(order.size(), 0);
+    visited.assign(order.size(), 0);
+    dirty.clear();
+    layoutDirty = false;
+}
+
+void SceneGraph::update() {
+    PROFILE_FUNCTION();
+    updatedNodes = 0;
+    if (layoutDirty) {
+        // everything moved around, one pass in order does it since parents come first
+        layout();
+        for (uint32_t i = 0; i < order.size(); i++)
+            worlds[i] = parentIndex[i] == DEAD ? locals[i] : worlds[parentIndex[i]] * locals[i];
+        updatedNodes = order.size();
+        return;
+    }
+    if (dirty.empty()) return;
+    // shallowest first, so a dirty node under another dirty node is already done by the time we get to it
+    walk.clear();
+    for (SceneNodeId id : dirty) {
+        if (!alive(id)) continue;
+        dirtyFlags[slots[id]] = 0;
+        walk.push_back(slots[id]);
+    }
+    dirty.clear();
+    std::sort(walk.begin(), walk.end());
+    size_t roots = walk.size();
+    updateStamp++;
+    for (size_t r = 0; r < roots; r++) {
+        uint32_t root = walk[r];
+        if (visited[root] == updateStamp) continue;
+        // the subtree, breadth first, queued on the end of walk
+        size_t queued = walk.size();
+        walk.push_back(root);
+        for (size_t k = queued; k < walk.size(); k++) {
+            uint32_t i = walk[k];
+            worlds[i] = parentIndex[i] == DEAD ? locals[i] : worlds[parentIndex[i]] * locals[i];
+            visited[i] = updateStamp;
+            updatedNodes++;
+            for (uint32_t c = firstChild[i]; c < firstChild[i] + childCount[i]; c++) walk.push_back(c);
+        }
+        walk.resize(roots);
+    }
+}
+
+void attachElement(Element* e, SceneNodeId parent, const glm::mat4& local) {
+    if (e->sceneNode == NO_SCENE_NODE) {
+        e->sceneNode = sceneGraph.create(parent);
+        sceneGraph.setElement(e->sceneNode, e);
+    } else
+        sceneGraph.setParent(e->sceneNode, parent);
+    sceneGraph.setLocal(e->sceneNode, local);
+    e->attached = true;
+}
+
+void detachElement(Element* e) {
+    if (!e->attached) return;
+    // fold the orientation we had from the graph into our own, so we don't snap back
+    e->orientation = glm::normalize(glm::quat_cast(e->sceneBasis) * e->orientation);
+    e->previousOrientation = e->renderOrientation = e->orientation;
+    e->sceneBasis = glm::mat3(1.0f);
+    e->attached = false;
+    // the node stays, as a root that follows us, in case anything hangs off it
+    sceneGraph.setParent(e->sceneNode, NO_SCENE_NODE);
+}
+
+SceneNodeId elementNode(Element* e) {
+    if (e->sceneNode == NO_SCENE_NODE) {
+        e->sceneNode = sceneGraph.create();
+        sceneGraph.setElement(e->sceneNode, e);
+    }
+    return e->sceneNode;
+}
+
+void updateSceneGraph() {
+    PROFILE_FUNCTION();
+    sceneGraph.eachElement([&](SceneNodeId node, Element* e) {
+        if (!e->attached) sceneGraph.setLocal(node, e->getMatrix());
+    });
+    sceneGraph.update();
+    sceneGraph.eachElement([&](SceneNodeId node, Element* e) {
+        if (!e->attached) return;
+        const glm::mat4& world = sceneGraph.world(node);
+        e->position = e->previousPosition = glm::vec3(world[3]);
+        e->renderOffset = glm::vec3(0.0f);
+        glm::mat3 basis(world);
+        if (basis == e->sceneBasis) return;
+        e->sceneBasis = basis;
+        e->fitBounds();
+    });
+}
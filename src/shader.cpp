@@ -9,28 +9,44 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shader.hpp"
+
+// reads a shader file, replacing any #include "file" lines with that file's contents (relative to the including file)
+// glsl has no includes of its own, this lets shaders share things like the lighting code
+static bool loadShaderSource(const std::string& file, std::string& out) {
+    std::ifstream stream(file);
+    if (!stream) {
+        std::cout << "Cannot read " << file << std::endl;
+        return false;
+    }
+    std::string directory = file.substr(0, file.find_last_of('/') + 1);
+    std::stringstream buffer;
+    std::string line;
+    while (std::getline(stream, line)) {
+        size_t start = line.find("#include \"");
+        if (start != std::string::npos && line.find_first_not_of(" \t") == start) {
+            size_t nameStart = start + 10;
+            size_t nameEnd = line.find('"', nameStart);
+            std::string included;
+            if (!loadShaderSource(directory + line.substr(nameStart, nameEnd - nameStart), included))
+                return false;
+            buffer << included << "\n";
+        } else {
+            buffer << line << "\n";
+        }
+    }
+    out = buffer.str();
+    return true;
+}
+
 Shader::Shader(std::string vertexShaderFile, std::string fragmentShaderFile) {
     std::string vertexShaderCode;
     std::string fragmentShaderCode;
-    std::ifstream vFile(vertexShaderFile);
-    std::ifstream fFile(fragmentShaderFile);
-    if (!vFile) {
-        std::cout << "Cannot read " << vertexShaderFile << std::endl;
+    if (!loadShaderSource(vertexShaderFile, vertexShaderCode))
         return;
-    }
-    std::stringstream vBuffer;
-    std::stringstream fBuffer;
-    vBuffer << vFile.rdbuf();
-    vertexShaderCode = vBuffer.str();
     const char* vertexShaderSource = vertexShaderCode.c_str();
-    
-    
-    if (!fFile) {
-        std::cout << "Cannot read " << fragmentShaderFile << std::endl;
+
+    if (!loadShaderSource(fragmentShaderFile, fragmentShaderCode))
         return;
-    }
-    fBuffer << fFile.rdbuf();
-    fragmentShaderCode = fBuffer.str();
     const char* fragmentShaderSource = fragmentShaderCode.c_str();
     // compile vertexShader
     int success;
@@ -75,15 +91,21 @@ void Shader::use() {
     glUseProgram(ID);
 }
 
-void Shader::setMat4(const std::string &name, const glm::mat4 &value) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+void Shader::setMat4(const char* name, const glm::mat4 &value) const {
+    glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, glm::value_ptr(value));
+}
+void Shader::setVec3(const char* name, const glm::vec3 &value) const {
+    glUniform3fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value));
+}
+void Shader::setFloat(const char* name, const float &value) const {
+    glUniform1f(glGetUniformLocation(ID, name), value);
 }
-void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+void Shader::setInt(const char* name, const int &value) const {
+    glUniform1i(glGetUniformLocation(ID, name), value);
 }
-void Shader::setFloat(const std::string &name, const float &value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setVec2(const char* name, const glm::vec2 &value) const {
+    glUniform2fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value));
 }
-void Shader::setInt(const std::string &name, const int &value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+void Shader::setIVec3(const char* name, const glm::ivec3 &value) const {
+    glUniform3iv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value));
 }
\ No newline at end of file
@@ -5,10 +5,22 @@
 Shader* objectShader = nullptr;
 Shader* lightShader  = nullptr;
 Shader* debugShader  = nullptr;
+Shader* gbufferShader = nullptr;
+Shader* deferredShader = nullptr;
+Shader* depthShader = nullptr;
+Shader* pointShadowShader = nullptr;
+Shader* skyboxShader = nullptr;
+Shader* hudShader = nullptr;
 
 // needs to be called after window is initalized, because Shader uses some opengl functions
 void initShaders() {
     objectShader = new Shader("shaders/object.vert", "shaders/object.frag");
     lightShader  = new Shader("shaders/light.vert", "shaders/light.frag");
     debugShader  = new Shader("shaders/debug.vert", "shaders/debug.frag");
+    gbufferShader = new Shader("shaders/object.vert", "shaders/gbuffer.frag");
+    deferredShader = new Shader("shaders/deferred.vert", "shaders/deferred.frag");
+    depthShader = new Shader("shaders/depth.vert", "shaders/depth.frag");
+    pointShadowShader = new Shader("shaders/pointshadow.vert", "shaders/pointshadow.frag");
+    skyboxShader = new Shader("shaders/skybox.vert", "shaders/skybox.frag");
+    hudShader = new Shader("shaders/hud.vert", "shaders/hud.frag");
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include <iostream>
+#include <algorithm>
+#include <cfloat>
+#include <math.h>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shadows.hpp"
+#include "lighting.hpp"
+#include "shader_def.hpp"
+#include "memory_tracking.hpp"
+
+// look direction and up vector for each cube face, in GL_TEXTURE_CUBE_MAP_POSITIVE_X.. order
+static const glm::vec3 cubeFaceDirs[6] = {
+    { 1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}
+};
+static const glm::vec3 cubeFaceUps[6] = {
+    {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}
+};
+
+// sphere vs box, for "did something move inside this light's range"
+static bool sphereTouchesBox(glm::vec3 center, float radius, glm::vec3 min, glm::vec3 max) {
+    glm::vec3 closest = glm::clamp(center, min, max);
+    glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+// does the box land anywhere on the shadow map this matrix renders
+static bool boxInShadowView(const glm::mat4& matrix, glm::vec3 min, glm::vec3 max) {
+    glm::vec2 ndcMin(FLT_MAX), ndcMax(-FLT_MAX);
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 c((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        glm::vec4 p = matrix * glm::vec4(c, 1.0f); // orthographic, w is 1
+        ndcMin = glm::min(ndcMin, glm::vec2(p));
+        ndcMax = glm::max(ndcMax, glm::vec2(p));
+    }
+    return ndcMax.x >= -1.0f && ndcMin.x <= 1.0f && ndcMax.y >= -1.0f && ndcMin.y <= 1.0f;
+}
+
+void ShadowMaps::init() {
+    MEMORY_TAG(MemoryTag::Shadows);
+    glGenFramebuffers(1, &FBO);
+
+    glGenTextures(1, &cascadeTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, CASCADE_RESOLUTION, CASCADE_RESOLUTION, SHADOW_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // linear + compare mode gives us 2x2 pcf for free
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glGenTextures(1, &cubeTexture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, cubeTexture);
+    glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT24, POINT_SHADOW_RESOLUTION, POINT_SHADOW_RESOLUTION, MAX_SHADOWED_POINT_LIGHTS * 6, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    // 24 bit depth ends up stored as 4 bytes
+    trackGpuObject(GpuObjectKind::Texture, cascadeTexture, textureBytes(CASCADE_RESOLUTION, CASCADE_RESOLUTION, SHADOW_CASCADES, 4, false), MemoryTag::Shadows);
+    trackGpuObject(GpuObjectKind::Texture, cubeTexture, textureBytes(POINT_SHADOW_RESOLUTION, POINT_SHADOW_RESOLUTION, MAX_SHADOWED_POINT_LIGHTS * 6, 4, false), MemoryTag::Shadows);
+}
+
+bool ShadowMaps::isCaster(const ElementDrawState& e) const {
+    return e.castShadow && !e.debug && e.shader == objectShader && e.depthVAO;
+}
+
+void ShadowMaps::update(const std::vector<ElementDrawState>& states, const std::vector<ElementDrawState*>& lights, const DirectionalLight& sun,
+                        const glm::mat4& view, float fov, float aspect, float zNear, float zFar, glm::vec3 cameraPos) {
+    MEMORY_TAG(MemoryTag::Shadows);
+    stats = ShadowStats();
+    findMovedCasters(states);
+    assignPointSlots(lights, cameraPos);
+
+    bool sunOn = sun.castShadows && sun.color != glm::vec3(0.0f);
+    if (sunOn) {
+        fitCascades(sun, view, fov, aspect, zNear, zFar);
+        for (Cascade& cascade : cascades) {
+            if (cascade.wantedMatrix != cascade.renderedMatrix) {
+                cascade.dirty = true;
+                continue;
+            }
+            for (size_t i = 0; i < movedMin.size() && !cascade.dirty; i++) {
+                if (boxInShadowView(cascade.renderedMatrix, movedMin[i], movedMax[i]))
+                    cascade.dirty = true;
+            }
+        }
+    }
+    for (PointShadow& shadow : pointShadows) {
+        if (!shadow.light) continue;
+        shadow.range = calcLightRange(*shadow.state);
+        if (shadow.state->position != shadow.renderedPosition) {
+            shadow.pendingFaces = 0x3F;
+            continue;
+        }
+        for (size_t i = 0; i < movedMin.size() && shadow.pendingFaces != 0x3F; i++) {
+            if (sphereTouchesBox(shadow.state->position, shadow.range, movedMin[i], movedMax[i]))
+                shadow.pendingFaces = 0x3F;
+        }
+    }
+
+    // spend the budget, cascades first (closest cascade is what you notice most), then point lights closest first
+    int budget = SHADOW_UPDATE_BUDGET;
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    if (sunOn) {
+        for (int i = 0; i < SHADOW_CASCADES; i++) {
+            if (!cascades[i].dirty) continue;
+            if (budget <= 0) {
+                stats.viewsPending++;
+                continue;
+            }
+            renderCascade(i, states, sun);
+            budget--;
+        }
+    }
+    for (const std::pair<float, ElementDrawState*>& entry : lightOrder) {
+        int slot = entry.second->shadowSlot;
+        if (slot < 0) continue;
+        PointShadow& shadow = pointShadows[slot];
+        if (shadow.pendingFaces == 0x3F)
+            shadow.renderedPosition = shadow.state->position;
+        for (int face = 0; face < 6; face++) {
+            if (!(shadow.pendingFaces & (1 << face))) continue;
+            if (budget <= 0) {
+                stats.viewsPending++;
+                continue;
+            }
+            renderCubeFace(slot, face, states);
+            shadow.pendingFaces &= ~(1 << face);
+            budget--;
+        }
+    }
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMaps::findMovedCasters(const std::vector<ElementDrawState>& states) {
+    movedMin.clear();
+    movedMax.clear();
+    casterPass++;
+    for (const ElementDrawState& e : states) {
+        if (!isCaster(e)) continue;
+        glm::mat4 matrix = e.matrix;
+        glm::vec3 min = e.min;
+        glm::vec3 max = e.max;
+        auto it = casterStates.find(e.element);
+        if (it == casterStates.end()) {
+            // new caster, counts as having moved into place
+            casterStates[e.element] = CasterState{matrix, min, max, casterPass};
+            movedMin.push_back(min);
+            movedMax.push_back(max);
+            continue;
+        }
+        it->second.seen = casterPass;
+        if (it->second.matrix == matrix) continue; // anchored stuff always ends up here
+        // both where it was and where it is now need redrawing
+        movedMin.push_back(it->second.min);
+        movedMax.push_back(it->second.max);
+        movedMin.push_back(min);
+        movedMax.push_back(max);
+        it->second = CasterState{matrix, min, max, casterPass};
+    }
+    // gone since last time, its shadow is still baked in wherever it was. forgetting it also means a new
+    // Element that gets the same address isn't mistaken for it
+    for (auto it = casterStates.begin(); it != casterStates.end();) {
+        if (it->second.seen == casterPass) {
+            ++it;
+            continue;
+        }
+        movedMin.push_back(it->second.min);
+        movedMax.push_back(it->second.max);
+        it = casterStates.erase(it);
+    }
+}
+
+void ShadowMaps::assignPointSlots(const std::vector<ElementDrawState*>& lights, glm::vec3 cameraPos) {
+    lightOrder.clear();
+    for (ElementDrawState* light : lights) {
+        light->shadowSlot = -1;
+        if (!light->pointLightShadows) continue;
+        glm::vec3 toCamera = light->position - cameraPos;
+        lightOrder.push_back({glm::dot(toCamera, toCamera), light});
+    }
+    std::sort(lightOrder.begin(), lightOrder.end(), [](const std::pair<float, ElementDrawState*>& a, const std::pair<float, ElementDrawState*>& b) {
+        return a.first < b.first;
+    });
+    if (lightOrder.size() > MAX_SHADOWED_POINT_LIGHTS)
+        lightOrder.resize(MAX_SHADOWED_POINT_LIGHTS);
+
+    // lights that kept their slot keep their (maybe still valid) shadow map
+    for (int slot = 0; slot < MAX_SHADOWED_POINT_LIGHTS; slot++) {
+        PointShadow& shadow = pointShadows[slot];
+        ElementDrawState* kept = nullptr;
+        for (const std::pair<float, ElementDrawState*>& entry : lightOrder) {
+            if (entry.second->element == shadow.light) kept = entry.second;
+        }
+        shadow.state = kept;
+        if (kept)
+            kept->shadowSlot = slot;
+        else
+            shadow.light = nullptr;
+    }
+    // everyone else gets a free slot and a full redraw
+    for (const std::pair<float, ElementDrawState*>& entry : lightOrder) {
+        if (entry.second->shadowSlot >= 0) continue;
+        for (int slot = 0; slot < MAX_SHADOWED_POINT_LIGHTS; slot++) {
+            if (pointShadows[slot].light) continue;
+            pointShadows[slot].light = entry.second->element;
+            pointShadows[slot].state = entry.second;
+            pointShadows[slot].pendingFaces = 0x3F;
+            entry.second->shadowSlot = slot;
+            break;
+        }
+    }
+}
+
+void ShadowMaps::fitCascades(const DirectionalLight& sun, const glm::mat4& view, float fov, float aspect, float zNear, float zFar) {
+    // shadows don't need to reach all the way to the far plane
+    float shadowDistance = std::min(zFar, 60.0f);
+    for (int i = 0; i <= SHADOW_CASCADES; i++) {
+        // mix of logarithmic and even splits
+        float t = (float)i / SHADOW_CASCADES;
+        float logSplit = zNear * powf(shadowDistance / zNear, t);
+        float evenSplit = zNear + (shadowDistance - zNear) * t;
+        cascadeSplits[i] = glm::mix(evenSplit, logSplit, 0.75f);
+    }
+    if (sun.direction != lastSunDirection) {
+        for (Cascade& cascade : cascades) cascade.dirty = true;
+        lastSunDirection = sun.direction;
+    }
+
+    glm::mat4 invView = glm::inverse(view);
+    float tanHalfY = tanf(glm::radians(fov) * 0.5f);
+    float tanHalfX = tanHalfY * aspect;
+    glm::vec3 lightDir = glm::normalize(sun.direction);
+    glm::vec3 up = (glm::abs(lightDir.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    for (int i = 0; i < SHADOW_CASCADES; i++) {
+        Cascade& cascade = cascades[i];
+        // bounding sphere of this slice of the view frustum, a sphere doesn't change size when the camera turns
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int c = 0; c < 8; c++) {
+            float depth = (c & 4) ? cascadeSplits[i + 1] : cascadeSplits[i];
+            glm::vec4 viewCorner((c & 1 ? 1.0f : -1.0f) * tanHalfX * depth, (c & 2 ? 1.0f : -1.0f) * tanHalfY * depth, -depth, 1.0f);
+            corners[c] = glm::vec3(invView * viewCorner);
+            center += corners[c];
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (int c = 0; c < 8; c++)
+            radius = std::max(radius, glm::length(corners[c] - center));
+        radius = ceilf(radius * 16.0f) / 16.0f;
+
+        // pull the eye back past the sphere so casters between the sun and the slice still get drawn
+        float backDistance = 50.0f;
+        glm::mat4 lightView = glm::lookAt(center - lightDir * (radius + backDistance), center, up);
+        glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + backDistance);
+
+        // snap to whole texels so the shadow edges don't crawl when the camera moves
+        glm::mat4 matrix = lightProjection * lightView;
+        glm::vec4 origin = matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) * (CASCADE_RESOLUTION * 0.5f);
+        glm::vec2 offset = (glm::round(glm::vec2(origin)) - glm::vec2(origin)) * (2.0f / CASCADE_RESOLUTION);
+        lightProjection[3][0] += offset.x;
+        lightProjection[3][1] += offset.y;
+
+        cascade.wantedMatrix = lightProjection * lightView;
+        cascade.center = center;
+        cascade.radius = radius;
+    }
+}
+
+void ShadowMaps::renderCascade(int index, const std::vector<ElementDrawState>& states, const DirectionalLight& sun) {
+    Cascade& cascade = cascades[index];
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cascadeTexture, 0, index);
+    glViewport(0, 0, CASCADE_RESOLUTION, CASCADE_RESOLUTION);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    depthShader->use();
+    depthShader->setMat4("view", glm::mat4(1.0f));
+    depthShader->setMat4("projection", cascade.wantedMatrix);
+    for (const ElementDrawState& e : states) {
+        if (!isCaster(e)) continue;
+        if (!boxInShadowView(cascade.wantedMatrix, e.min, e.max)) continue;
+        e.drawDepth(*depthShader);
+        stats.casterDraws++;
+    }
+    cascade.renderedMatrix = cascade.wantedMatrix;
+    cascade.dirty = false;
+    stats.viewsRendered++;
+}
+
+void ShadowMaps::renderCubeFace(int slot, int face, const std::vector<ElementDrawState>& states) {
+    PointShadow& shadow = pointShadows[slot];
+    glm::vec3 lightPos = shadow.renderedPosition;
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cubeTexture, 0, slot * 6 + face);
+    glViewport(0, 0, POINT_SHADOW_RESOLUTION, POINT_SHADOW_RESOLUTION);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    pointShadowShader->use();
+    pointShadowShader->setMat4("view", glm::lookAt(lightPos, lightPos + cubeFaceDirs[face], cubeFaceUps[face]));
+    pointShadowShader->setMat4("projection", glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, shadow.range));
+    pointShadowShader->setVec3("lightPos", lightPos);
+    pointShadowShader->setFloat("range", shadow.range);
+    for (const ElementDrawState& e : states) {
+        if (!isCaster(e)) continue;
+        if (!sphereTouchesBox(lightPos, shadow.range, e.min, e.max)) continue;
+        e.drawDepth(*pointShadowShader);
+        stats.casterDraws++;
+    }
+    stats.viewsRendered++;
+}
+
+void ShadowMaps::bind(Shader& shader, const DirectionalLight& sun) const {
+    static const char* matrixNames[SHADOW_CASCADES] = {"cascadeMatrices[0]", "cascadeMatrices[1]", "cascadeMatrices[2]"};
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, cubeTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.use();
+    shader.setInt("cascadeShadowMap", 3);
+    shader.setInt("pointShadowMap", 4);
+    for (int i = 0; i < SHADOW_CASCADES; i++)
+        shader.setMat4(matrixNames[i], cascades[i].renderedMatrix);
+    shader.setVec3("sunDirection", glm::normalize(sun.direction));
+    shader.setVec3("sunColor", sun.color);
+    shader.setInt("sunShadows", sun.castShadows);
+}
+
+ShadowMaps::~ShadowMaps() {
+    untrackGpuObject(GpuObjectKind::Texture, cascadeTexture);
+    untrackGpuObject(GpuObjectKind::Texture, cubeTexture);
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteTextures(1, &cascadeTexture);
+    glDeleteTextures(1, &cubeTexture);
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "skybox.hpp"
+#include "shader_def.hpp"
+
+void Skybox::init(const std::vector<std::string>& faceFiles) {
+    cubemap.initCubemap(faceFiles);
+    glGenVertexArrays(1, &VAO);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS); // no visible seams where the faces meet
+}
+
+void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) const {
+    if (!loaded()) return;
+    // drop the translation, the sky is infinitely far away
+    glm::mat4 rotationOnly = glm::mat4(glm::mat3(view));
+    skyboxShader->use();
+    skyboxShader->setMat4("invViewProjection", glm::inverse(projection * rotationOnly));
+    skyboxShader->setInt("skybox", 0);
+    glActiveTexture(GL_TEXTURE0);
+    cubemap.use();
+
+    // depth is 1.0 everywhere, LEQUAL lets it pass where nothing was drawn, and it doesn't need to write depth
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    cubemap.unUse();
+}
+
+Skybox::~Skybox() {
+    if (VAO) glDeleteVertexArrays(1, &VAO);
+}
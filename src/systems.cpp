@@ -0,0 +1,326 @@
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "systems.hpp"
+#include "collision.hpp"
+#include "shader_def.hpp"
+#include "util.hpp"
+
+World world;
+unsigned long long physicsPairTests = 0;
+unsigned long long physicsBoxTests = 0, physicsBoxRejects = 0;
+
+// turned away from the world axes by its own orientation or a scene graph parent. without a mesh box
+// (localBounds) there's nothing to turn, the Bounds stay whatever they were set to
+static bool rotatedCollider(const Element& e, bool turned) {
+    if (e.localBoundsMin == e.localBoundsMax) return false;
+    return turned || e.sceneBasis != glm::mat3(1.0f);
+}
+
+ComponentMask elementMask(const Element& e) {
+    return elementMask(e, e.orientation != glm::quat(1.0f, 0.0f, 0.0f, 0.0f), e.angularVelocity != glm::vec3(0.0f));
+}
+
+ComponentMask elementMask(const Element& e, bool turned, bool spinning) {
+    ComponentMask mask = componentMask<Transform, Bounds, ElementLink>();
+    if (!e.anchored && !e.attached) mask |= componentMask<Motion>(); // attached things go where the scene graph says
+    if (e.hasCollision && !e.debug) {
+        mask |= componentMask<Collider>();
+        if (rotatedCollider(e, turned || spinning)) mask |= componentMask<OrientedBox>(); // spinning won't stay unturned for long
+    }
+    if (e.VAO) mask |= componentMask<Drawable>();
+    if (spinning) mask |= componentMask<Spin>();
+    return mask;
+}
+
+// the local box scaled by size, min stays min even if a size is negative
+static void scaledLocalBounds(const Element& e, glm::vec3& min, glm::vec3& max) {
+    glm::vec3 size(e.sizex, e.sizey, e.sizez);
+    min = glm::min(e.localBoundsMin * size, e.localBoundsMax * size);
+    max = glm::max(e.localBoundsMin * size, e.localBoundsMax * size);
+}
+
+void pushElement(World& world, Element& e) {
+    ComponentMask mask = elementMask(e);
+    if (!world.alive(e.entity)) {
+        e.entity = world.create(mask);
+        e.id = e.entity.index + 1; // slots are only reused once they're free, so no two live elements share an id
+        e.previousPosition = e.position; // new here, nothing to interpolate from
+        e.previousOrientation = e.orientation;
+    } else world.setMask(e.entity, mask); // nothing happens if the flags didn't change
+    Entity entity = e.entity;
+    *world.get<Transform>(entity) = Transform{e.position, e.previousPosition, e.orientation, e.previousOrientation};
+    *world.get<Bounds>(entity) = Bounds{e.bounding_box_corner1, e.bounding_box_corner2};
+    world.get<ElementLink>(entity)->element = &e;
+    if (mask & componentMask<Motion>()) {
+        Motion* motion = world.get<Motion>(entity);
+        motion->velocity = e.velocity;
+        motion->holdVelocity = e.holdVelocity;
+        motion->lastPosition = e.lastPosition;
+        motion->bounceAmount = e.bounce_amount;
+        motion->gravity = e.gravity;
+        motion->bounce = e.bounce;
+        motion->grounded = e.grounded;
+    }
+    if (mask & componentMask<Collider>())
+        world.get<Collider>(entity)->id = e.id;
+    if (mask & componentMask<OrientedBox>()) {
+        glm::vec3 localMin, localMax;
+        scaledLocalBounds(e, localMin, localMax);
+        *world.get<OrientedBox>(entity) = orientedBox(e.sceneBasis, e.orientation, localMin, localMax);
+    }
+    if (mask & componentMask<Spin>()) {
+        Spin* spin = world.get<Spin>(entity);
+        spin->angularVelocity = e.angularVelocity;
+        scaledLocalBounds(e, spin->localMin, spin->localMax);
+        spin->parentBasis = e.sceneBasis;
+    }
+    if (mask & componentMask<Drawable>())
+        *world.get<Drawable>(entity) = Drawable{&e, e.shader == objectShader && !e.debug};
+}
+
+Element* elementFor(const World& world, Entity entity) {
+    if (!world.alive(entity)) return nullptr;
+    return world.get<ElementLink>(entity)->element;
+}
+
+static std::vector<Element*> linkedElements; // reused, can't move entities between archetypes while walking them
+
+void pushElements(World& world) {
+    linkedElements.clear();
+    world.each<ElementLink>([&](Entity entity, ElementLink& link) {
+        linkedElements.push_back(link.element);
+    });
+    for (Element* e : linkedElements)
+        pushElement(world, *e);
+}
+
+void pullElements(World& world) {
+    world.eachChunk<ElementLink, Transform>([&](size_t count, Entity* entities, ElementLink* links, Transform* transforms) {
+        for (size_t i = 0; i < count; i++) {
+            Element* e = links[i].element;
+            e->position = transforms[i].position;
+            e->previousPosition = transforms[i].previousPosition;
+            e->orientation = e->renderOrientation = transforms[i].orientation;
+            e->previousOrientation = transforms[i].previousOrientation;
+        }
+    });
+    world.eachChunk<ElementLink, Motion>([&](size_t count, Entity* entities, ElementLink* links, Motion* motions) {
+        for (size_t i = 0; i < count; i++) {
+            Element* e = links[i].element;
+            e->velocity = motions[i].velocity;
+            e->lastPosition = motions[i].lastPosition;
+            e->grounded = motions[i].grounded;
+        }
+    });
+}
+
+void interpolateElements(World& world, float alpha) {
+    world.eachChunk<ElementLink, Transform>([&](size_t count, Entity* entities, ElementLink* links, Transform* transforms) {
+        for (size_t i = 0; i < count; i++) {
+            links[i].element->renderOffset = (transforms[i].previousPosition - transforms[i].position) * (1.0f - alpha);
+            // only what turned, and nlerp instead of slerp: a step is a small angle, and it's no trig
+            const glm::quat& from = transforms[i].previousOrientation;
+            const glm::quat& to = transforms[i].orientation;
+            if (from != to) {
+                float sign = glm::dot(from, to) < 0.0f ? -1.0f : 1.0f; // the short way round
+                links[i].element->renderOrientation = glm::normalize(to * alpha + from * (sign * (1.0f - alpha)));
+            }
+        }
+    });
+}
+
+// one chunk worth of things that can be hit
+struct ColliderSpan {
+    size_t count;
+    Transform* transforms;
+    Bounds* bounds;
+    Collider* colliders;
+    Motion* motions; // nullptr for anchored stuff
+    OrientedBox* boxes; // nullptr if none of these are rotated
+};
+static std::vector<ColliderSpan> colliderSpans; // rebuilt every step, reused so we don't allocate
+
+// push out along the SAT contact normal, the rotated version of the per axis code in stepBody
+static void resolveContact(glm::vec3& position, Motion& motion, Motion* otherMotion, const Contact& contact) {
+    glm::vec3& velocity = motion.velocity;
+    glm::vec3 n = contact.normal;
+    position += n * contact.depth;
+    float into = glm::dot(velocity, n); // < 0 if we're still moving into it
+    if (motion.bounce) {
+        if (into < 0.0f) {
+            velocity -= n * (into * (1.0f + motion.bounceAmount));
+            if (-into * motion.bounceAmount < 0.08f) velocity -= n * glm::dot(velocity, n);
+        }
+    } else {
+        if (otherMotion) otherMotion->velocity += n * (into - glm::dot(otherMotion->velocity, n));
+        if (into < 0.0f) velocity -= n * into;
+        if (n.y > 0.7f) motion.grounded = true; // standing on it, up to a ~45 degree slope
+    }
+}
+
+static void stepBody(Transform& transform, Bounds& bounds, Motion& motion, const Collider* self, const OrientedBox* selfBox, float dt) {
+    glm::vec3& position = transform.position;
+    glm::vec3& velocity = motion.velocity;
+    if (motion.gravity) {
+        velocity.y += -9.8f * dt;
+    }
+    if (motion.holdVelocity != glm::vec3(0.0f)) {
+        velocity += motion.holdVelocity;
+    }
+
+    // now dampen so it doesn't fly forever
+    float damping = 2.0f; // units per second
+    if (glm::length(velocity) > 0.0f) {
+        glm::vec3 decel = glm::normalize(velocity) * damping * dt;
+        if (glm::length(decel) > glm::length(velocity))
+            velocity = glm::vec3(0.0f); // stop completely
+        else {
+            velocity -= decel;
+        }
+    }
+    if (glm::length(velocity) < 0.1f) {
+        velocity = glm::vec3(0.0f);
+    }
+    position += velocity * dt; // apply velocity
+    motion.grounded = false; // we check if grounded later so we js reset until then
+
+    if (motion.lastPosition != position && self) {
+        glm::vec3 min = position + bounds.min, max = position + bounds.max;
+        for (const ColliderSpan& span : colliderSpans) {
+            for (size_t i = 0; i < span.count; i++) {
+                const Transform& other = span.transforms[i];
+                if (&other == &transform) continue;
+                if (other.position == position) continue; // oh the horrors
+                if (span.colliders[i].id == self->id) continue;
+
+                physicsPairTests++;
+                glm::vec3 otherMin = other.position + span.bounds[i].min, otherMax = other.position + span.bounds[i].max;
+                // AABBCollideDetect, written out here so it inlines into the loop
+                if (!(min.x < otherMax.x && max.x > otherMin.x && min.y < otherMax.y && max.y > otherMin.y && min.z < otherMax.z && max.z > otherMin.z)) continue;
+                Motion* otherMotion = span.motions ? &span.motions[i] : nullptr; // anchored things don't get pushed
+                const OrientedBox* otherBox = span.boxes ? &span.boxes[i] : nullptr;
+                if (selfBox || otherBox) {
+                    // something's rotated, so the AABBs overlapping doesn't mean much yet
+                    physicsBoxTests++;
+                    Contact contact;
+                    if (!collideBoxes(position, selfBox ? *selfBox : axisAlignedBox(bounds),
+                                      other.position, otherBox ? *otherBox : axisAlignedBox(span.bounds[i]), contact)) {
+                        physicsBoxRejects++;
+                        continue;
+                    }
+                    resolveContact(position, motion, otherMotion, contact);
+                    min = position + bounds.min;
+                    max = position + bounds.max;
+                    continue;
+                }
+                float px = std::min(max.x, otherMax.x) - std::max(min.x, otherMin.x);
+                float py = std::min(max.y, otherMax.y) - std::max(min.y, otherMin.y);
+                float pz = std::min(max.z, otherMax.z) - std::max(min.z, otherMin.z);
+                // we're checking which axis has the most overlap, setting pos of 1 object to not be inside the other, setting vel on that axis to 0
+                if (motion.bounce) {
+                    if (px < py && px < pz) {
+                        float dir = (position.x < other.position.x) ? -1.0f : 1.0f;
+                        position.x += px * dir;
+                        velocity.x = -velocity.x * motion.bounceAmount;
+                        if (glm::abs(velocity.x) < 0.08f) velocity.x = 0.0f;
+                    }
+                    else if (py < pz) {
+                        if (motion.grounded) return;
+                        velocity.y = -velocity.y * motion.bounceAmount;
+                        if (glm::abs(velocity.y) < 0.08f) velocity.y = 0.0f;
+                    }
+                    else {
+                        float dir = (position.z < other.position.z) ? -1.0f : 1.0f;
+                        position.z += pz * dir;
+                        velocity.z = -velocity.z;
+                        if (glm::abs(velocity.z) < 0.08f) velocity.z = 0.0f;
+                    }
+                } else {
+                    if (px < py && px < pz) {
+                        float dir = (position.x < other.position.x) ? -1.0f : 1.0f;
+                        position.x += px * dir;
+                        if (otherMotion) otherMotion->velocity.x = velocity.x;
+                        velocity.x = 0;
+                    } else if (py < pz) { // y collide
+                        float dir = (position.y < other.position.y) ? -1.0f : 1.0f;
+                        position.y += py * dir;
+                        if (otherMotion) otherMotion->velocity.y = velocity.y;
+                        if (dir == 1.0f) // if we are falling/pushing down
+                            motion.grounded = true;
+                        velocity.y = 0.0f;
+                    } else {
+                        float dir = (position.z < other.position.z) ? -1.0f : 1.0f;
+                        position.z += pz * dir;
+                        if (otherMotion) otherMotion->velocity.z = velocity.z;
+                        velocity.z = 0;
+                    }
+                }
+                // we moved, later tests have to see where we are now
+                min = position + bounds.min;
+                max = position + bounds.max;
+            }
+        }
+    }
+
+    motion.lastPosition = position;
+}
+
+bool physicsStep(World& world, float dt, const std::function<bool()>& shouldStop) {
+    // everything, not just what has Motion, so anchored stuff moved by hand doesn't interpolate from forever ago
+    world.eachChunk<Transform>([&](size_t count, Entity* entities, Transform* transforms) {
+        for (size_t i = 0; i < count; i++) {
+            transforms[i].previousPosition = transforms[i].position;
+            transforms[i].previousOrientation = transforms[i].orientation;
+        }
+    });
+    // dq/dt = 0.5 * w * q, one euler step and a normalize. no trig, and fine at the step sizes we run.
+    // then the boxes go around wherever that left us, before anything gets tested against them
+    world.eachArchetype(componentMask<Transform, Spin, Bounds>(), [&](Archetype& archetype) {
+        for (size_t c = 0; c < archetype.chunks.size(); c++) {
+            Transform* transforms = archetype.column<Transform>(c);
+            Spin* spins = archetype.column<Spin>(c);
+            Bounds* bounds = archetype.column<Bounds>(c);
+            OrientedBox* boxes = archetype.column<OrientedBox>(c); // nullptr if these don't collide
+            for (size_t i = 0; i < archetype.chunks[c].count; i++) {
+                glm::quat& q = transforms[i].orientation;
+                glm::vec3 w = spins[i].angularVelocity * (0.5f * dt);
+                q = glm::normalize(q + glm::quat(0.0f, w.x, w.y, w.z) * q);
+                if (spins[i].localMin == spins[i].localMax) continue;
+                std::array<glm::vec3, 2> rotatedAABB = calcTransformedAABB(spins[i].localMin, spins[i].localMax, glm::mat4(spins[i].parentBasis * glm::mat3_cast(q)));
+                bounds[i].min = rotatedAABB[0];
+                bounds[i].max = rotatedAABB[1];
+                if (boxes) turnBox(boxes[i], q);
+            }
+        }
+    });
+
+    colliderSpans.clear();
+    world.eachArchetype(componentMask<Transform, Bounds, Collider>(), [&](Archetype& archetype) {
+        for (size_t c = 0; c < archetype.chunks.size(); c++)
+            colliderSpans.push_back({archetype.chunks[c].count, archetype.column<Transform>(c), archetype.column<Bounds>(c),
+                archetype.column<Collider>(c), archetype.column<Motion>(c), archetype.column<OrientedBox>(c)});
+    });
+
+    bool finished = true;
+    size_t stepped = 0;
+    world.eachArchetype(componentMask<Transform, Bounds, Motion>(), [&](Archetype& archetype) {
+        for (size_t c = 0; c < archetype.chunks.size() && finished; c++) {
+            Transform* transforms = archetype.column<Transform>(c);
+            Bounds* bounds = archetype.column<Bounds>(c);
+            Motion* motions = archetype.column<Motion>(c);
+            Collider* colliders = archetype.column<Collider>(c); // nullptr if these don't collide
+            OrientedBox* boxes = archetype.column<OrientedBox>(c);
+            for (size_t i = 0; i < archetype.chunks[c].count; i++) {
+                stepBody(transforms[i], bounds[i], motions[i], colliders ? &colliders[i] : nullptr, boxes ? &boxes[i] : nullptr, dt);
+                if ((++stepped & 255) == 0 && shouldStop && shouldStop()) {
+                    finished = false;
+                    break;
+                }
+            }
+        }
+    });
+    return finished;
+}
@@ -1,11 +1,14 @@
 #include <iostream>
+#include <algorithm>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 #include "texture.hpp"
+#include "memory_tracking.hpp"
 void Texture::init(std::string textureFile) {
+    MEMORY_TAG(MemoryTag::Textures);
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -33,6 +36,7 @@ void Texture::init(std::string textureFile) {
 
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        trackGpuObject(GpuObjectKind::Texture, texture, textureBytes(width, height, 1, nrChannels, true), MemoryTag::Textures);
     }
     else
     {
@@ -41,12 +45,87 @@ void Texture::init(std::string textureFile) {
     stbi_image_free(data);
 }
 Texture::~Texture() {
+    if (!texture) return; // nothing was loaded, and there might not even be a GL context
+    untrackGpuObject(GpuObjectKind::Texture, texture);
     glDeleteTextures(1, &texture);
 }
 
-void Texture::use() const {
+void Texture::initCubemap(const std::vector<std::string>& faceFiles, int maxFaceSize) {
+    if (faceFiles.size() != 6) {
+        std::cout << "texture.cpp: a cubemap needs 6 faces, got " << faceFiles.size() << "\n";
+        return;
+    }
+    MEMORY_TAG(MemoryTag::Textures);
+    target = GL_TEXTURE_CUBE_MAP;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    std::string loadedFile;
+    std::vector<unsigned char> face;
+    int faceSize = 0;
+    for (int i = 0; i < 6; i++) {
+        if (faceFiles[i] != loadedFile) { // only decode each file once
+            int width, height, nrChannels;
+            unsigned char *data = stbi_load(faceFiles[i].c_str(), &width, &height, &nrChannels, 3);
+            if (!data) {
+                std::cout << "Failed to load texture " << faceFiles[i] << std::endl;
+                face.clear();
+                loadedFile.clear();
+                continue;
+            }
+            // middle square of the image, box filtered down by a whole number so it fits in maxFaceSize
+            int side = std::min(width, height);
+            int step = (side + maxFaceSize - 1) / maxFaceSize;
+            faceSize = side / step;
+            int x0 = (width - faceSize * step) / 2, y0 = (height - faceSize * step) / 2;
+            face.resize(faceSize * faceSize * 3);
+            for (int y = 0; y < faceSize; y++) {
+                for (int x = 0; x < faceSize; x++) {
+                    for (int c = 0; c < 3; c++) {
+                        int sum = 0;
+                        for (int sy = 0; sy < step; sy++)
+                            for (int sx = 0; sx < step; sx++)
+                                sum += data[((y0 + y*step + sy) * width + x0 + x*step + sx) * 3 + c];
+                        face[(y * faceSize + x) * 3 + c] = sum / (step * step);
+                    }
+                }
+            }
+            stbi_image_free(data);
+            loadedFile = faceFiles[i];
+        }
+        if (face.empty()) continue;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of 3 byte pixels aren't always 4 byte aligned
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, face.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    trackGpuObject(GpuObjectKind::Texture, texture, textureBytes(faceSize, faceSize, 6, 3, true), MemoryTag::Textures);
+}
+
+void Texture::initPixels(const unsigned char* pixels, int width, int height, GLenum format, GLenum filter) {
+    glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    int channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+    trackGpuObject(GpuObjectKind::Texture, texture, textureBytes(width, height, 1, channels, false), MemoryTag::Textures);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::use() const {
+    glBindTexture(target, texture);
 }
 void Texture::unUse() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(target, 0);
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include <glm/glm.hpp>
 #include "util.hpp"
+#include "memory_tracking.hpp"
 #include <math.h>
 #include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -23,6 +26,7 @@ bool AABBCollideDetect(glm::vec3 bounding_box_corner1, glm::vec3 bounding_box_co
     return false;
 }
 std::vector<float> calcBoundingBoxVerts(glm::vec3 c1, glm::vec3 c2, glm::vec3 color, bool debug) {
+    MEMORY_TAG(MemoryTag::Debug);
     std::vector<float> vertices;
     
     float minX = std::min(c1.x, c2.x);
@@ -69,51 +73,11 @@ std::vector<float> calcBoundingBoxVerts(glm::vec3 c1, glm::vec3 c2, glm::vec3 co
     // }
     return vertices;
 }
-// returns ID of VAO,VBO of new debug line
-glm::uvec2 newDebugLine() {
-    unsigned int debugVAO;
-    unsigned int debugVBO; 
-    glGenVertexArrays(1, &debugVAO);
-    glGenBuffers(1, &debugVBO);
-
-    glBindVertexArray(debugVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, debugVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 12, nullptr, GL_DYNAMIC_DRAW); // GL_DYNAMIC_DRAW means we are updating this often, probably not every frame though
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    return glm::uvec2(debugVAO, debugVBO);
-}
-void drawDebugLine(unsigned int VAO, unsigned int VBO, glm::vec3 origin, glm::vec3 direction, float length, Shader& debugShader, const glm::mat4& view, const glm::mat4& projection) {
-    direction = glm::normalize(direction);
-    glm::vec3 color = glm::abs(direction);
-    std::vector<float> lineVertices = {
-        origin.x, origin.y, origin.z, color.x, color.y, color.z,
-        origin.x + (length * direction.x), origin.y + (length * direction.y), origin.z + (length * direction.z), color.x, color.y, color.z
-    };
-
-    // glDisable(GL_DEPTH_TEST);
-    glLineWidth(0.5f);
-    debugShader.use();
-    debugShader.setMat4("view", view);
-    debugShader.setMat4("projection", projection);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * lineVertices.size(), lineVertices.data()); // so cool!
-
-    glDrawArrays(GL_LINES, 0, 2);
-    // glEnable(GL_DEPTH_TEST);
-}
-// we are passing entire vertices std::vector in now, we should probably a vector for each element with js the pos coords in the future
-std::vector<glm::vec3> calcBoundingBoxPoints(std::vector<float> vertices) {
+// we are passing entire vertices in now, we should probably a vector for each element with js the pos coords in the future
+std::array<glm::vec3, 2> calcBoundingBoxPoints(const float* vertices, size_t count, uint stride) {
     glm::vec3 min = glm::vec3(0.0f,0.0f,0.0f);
     glm::vec3 max = glm::vec3(0.0f,0.0f,0.0f);
-    for (size_t i = 0; i < vertices.size(); i=i+11) {
+    for (size_t i = 0; i < count; i=i+stride) {
         min.x = std::min(min.x, vertices[i+0]);
         min.y = std::min(min.y, vertices[i+1]);
         min.z = std::min(min.z, vertices[i+2]);
@@ -122,21 +86,23 @@ std::vector<glm::vec3> calcBoundingBoxPoints(std::vector<float> vertices) {
         max.y = std::max(max.y, vertices[i+1]);
         max.z = std::max(max.z, vertices[i+2]);
     }
-    return std::vector<glm::vec3> {
-        min, max
-    };
+    return {min, max};
 }
 
-std::vector<float> calcRotatedVerts(std::vector<float> vertices, glm::mat4 rotation, uint stride) {
-    std::vector<float> rotatedVerts = vertices;
-    for (uint i = 0; i < vertices.size(); i = i + stride) {
-        glm::vec3 rotatedVert = rotation * glm::vec4(vertices[i+0], vertices[i+1], vertices[i+2], 1.0f);
-        rotatedVerts[i+0] = rotatedVert.x;
-        rotatedVerts[i+1] = rotatedVert.y;
-        rotatedVerts[i+2] = rotatedVert.z;
+// jim arvo's trick from graphics gems: every output axis is a sum of the input axes scaled by one row of the matrix,
+// so the smallest/biggest it can get is picking the smaller/bigger end of each input axis separately. 9 multiplies instead of 8 corners
+std::array<glm::vec3, 2> calcTransformedAABB(glm::vec3 min, glm::vec3 max, const glm::mat4& transform) {
+    glm::vec3 newMin = glm::vec3(transform[3]);
+    glm::vec3 newMax = newMin;
+    for (int i = 0; i < 3; i++) { // output axis
+        for (int j = 0; j < 3; j++) { // input axis, glm is column major so this is row i column j
+            float a = transform[j][i] * min[j];
+            float b = transform[j][i] * max[j];
+            newMin[i] += std::min(a, b);
+            newMax[i] += std::max(a, b);
+        }
     }
-
-    return rotatedVerts;
+    return {newMin, newMax};
 }
 
 Rayhit Raycast(glm::vec3 origin, glm::vec3 direction, std::vector<Element*>& Objects, Element* caster) { // https://gdbooks.gitbooks.io/3dcollisions/content/Chapter3/raycast_aabb.html
@@ -171,4 +137,12 @@ Rayhit Raycast(glm::vec3 origin, glm::vec3 direction, std::vector<Element*>& Obj
         // return tmin;
     }
     return hit;
-}
\ No newline at end of file
+}
+size_t currentRSS() {
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    long pages = 0, residentPages = 0;
+    if (fscanf(file, "%ld %ld", &pages, &residentPages) != 2) residentPages = 0;
+    fclose(file);
+    return (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE);
+}